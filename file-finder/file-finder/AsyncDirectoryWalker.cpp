@@ -0,0 +1,304 @@
+#include <iostream>
+#include <filesystem>
+#include <system_error>
+#include "ThreadSafeQueue.h"
+#include "FileIdentity.h"
+#include "ConcurrentIdentitySet.h"
+#include "AsyncDirectoryWalker.h"
+
+using namespace std;
+using namespace filesystem;
+using namespace fileFinder;
+
+AsyncDirectoryWalker::AsyncDirectoryWalker(const WalkOptions &options /*= WalkOptions()*/) :
+    m_options(options),
+    m_completions(std::make_unique<ThreadSafeQueue<std::shared_ptr<Completion>>>())
+{
+}
+
+AsyncDirectoryWalker::~AsyncDirectoryWalker()
+{
+    Stop();
+    for (auto &thread : m_ioThreads)
+    {
+        if (thread->joinable())
+        {
+            thread->join();
+        }
+    }
+}
+
+size_t AsyncDirectoryWalker::AddDevice(uint64_t deviceId, int queueDepth)
+{
+    Device device;
+    device.Id = deviceId;
+    device.QueueDepth = (queueDepth < 1) ? 1 : queueDepth;
+    device.Submissions = std::make_unique<SubmissionQueue>();
+    m_devices.push_back(std::move(device));
+    return m_devices.size() - 1;
+}
+
+void AsyncDirectoryWalker::Start()
+{
+    // The identity sets are shared by every I/O thread, so they're sized for all of them
+    size_t threadCount = 0;
+    for (auto &device : m_devices)
+    {
+        threadCount += static_cast<size_t>(device.QueueDepth);
+    }
+    if (m_options.FollowSymlinks)
+    {
+        m_visitedDirectories = std::make_unique<ConcurrentIdentitySet>(threadCount);
+    }
+    if (m_options.DedupeHardlinks)
+    {
+        m_seenHardlinks = std::make_unique<ConcurrentIdentitySet>(threadCount);
+    }
+
+    // Each I/O thread owns one slot of its device's queue depth, so this is the maximum number of directory reads we'll have blocked on each device at once.
+    for (size_t deviceIndex = 0; deviceIndex < m_devices.size(); deviceIndex++)
+    {
+        for (int ix = 0; ix < m_devices[deviceIndex].QueueDepth; ix++)
+        {
+            m_ioThreads.push_back(std::make_unique<thread>(&AsyncDirectoryWalker::ServiceSubmissions, this, deviceIndex));
+        }
+    }
+}
+
+void AsyncDirectoryWalker::ServiceSubmissions(size_t deviceIndex)
+{
+    auto &device = m_devices[deviceIndex];
+    while (!m_terminate)
+    {
+        auto submission = Dequeue(deviceIndex);
+
+        // Stop() wakes us with an empty submission, so we check again before doing any I/O
+        if (m_terminate)
+        {
+            break;
+        }
+
+        auto completion = std::make_shared<Completion>();
+        completion->Directory = submission.Directory;
+        completion->Tag = submission.Tag;
+        completion->DeviceIndex = deviceIndex;
+        completion->Depth = submission.Depth;
+        completion->Preferred = submission.Preferred;
+
+        // Once links are followed the same directory can be reached through more than one path (or round a cycle forever), so each one is only read the first time
+        FileIdentity directoryIdentity;
+        if (m_visitedDirectories && QueryFileIdentity(submission.Directory, directoryIdentity) && !m_visitedDirectories->Insert(directoryIdentity))
+        {
+            completion->AlreadyVisited = true;
+            m_completions->Enqueue(completion);
+            continue;
+        }
+
+        // Read the whole directory and stat each entry while we're here, so the consumer never blocks on the filesystem itself.
+        // We use the non-throwing overloads because an unreadable directory shouldn't end the walk for everything else in flight.
+        std::error_code error;
+        directory_iterator it(submission.Directory, directory_options::skip_permission_denied, error);
+        for (; !error && it != directory_iterator(); it.increment(error))
+        {
+            Entry entry;
+            entry.Name = it->path().filename().string();
+            entry.Path = it->path().string();
+
+            // Only symbolic links need a second stat to see what they point to, and only when we're following them
+            std::error_code statError;
+            entry.LinkType = it->symlink_status(statError).type();
+            auto type = (m_options.FollowSymlinks && entry.LinkType == file_type::symlink) ? it->status(statError).type() : entry.LinkType;
+            entry.IsDirectory = (type == file_type::directory);
+
+            // Staying on one file system costs an extra stat per directory, so we only pay for it when asked to
+            FileIdentity identity;
+            if (m_options.OneFileSystem && entry.IsDirectory && QueryFileIdentity(entry.Path, identity))
+            {
+                entry.OnOtherDevice = (identity.Device != device.Id);
+            }
+
+            // Likewise for hard links, only files with more than one link are recorded so the set stays small on typical trees
+            if (m_seenHardlinks && type == file_type::regular && QueryFileIdentity(entry.Path, identity) && identity.LinkCount > 1)
+            {
+                entry.IsDuplicateLink = !m_seenHardlinks->Insert(identity);
+            }
+
+            try
+            {
+                completion->Entries.push_back(std::move(entry));
+            }
+            catch (const std::bad_alloc &ex)
+            {
+                std::cout << " Error bad allocation caught in " << __FILE__ << " at line " << __LINE__ << endl;
+                std::cout << " Exception: " << ex.what() << endl;
+                std::terminate();
+            }
+        }
+
+        if (error)
+        {
+            completion->Error = error.message();
+        }
+
+        m_completions->Enqueue(completion);
+    }
+}
+
+bool AsyncDirectoryWalker::IsPreferred(const std::string &directory) const
+{
+    for (auto &hint : m_options.PreferredDirectories)
+    {
+        if (hint.find_first_of("/\\") != std::string::npos)
+        {
+            bool isHintOrBelow = directory.compare(0, hint.size(), hint) == 0 &&
+                (directory.size() == hint.size() || directory[hint.size()] == '/' || directory[hint.size()] == '\\');
+            if (isHintOrBelow)
+            {
+                return true;
+            }
+        }
+        else if (path(directory).filename().string() == hint)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void AsyncDirectoryWalker::Enqueue(size_t deviceIndex, Submission submission)
+{
+    auto depth = static_cast<int64_t>(submission.Depth);
+    switch (m_options.Order)
+    {
+    case TraversalOrder::DepthFirst:
+        submission.Key = -depth;
+        break;
+    case TraversalOrder::BreadthFirst:
+        submission.Key = depth;
+        break;
+    case TraversalOrder::Priority:
+        submission.Key = depth + (submission.Preferred ? 0 : NOT_PREFERRED_PENALTY);
+        break;
+    }
+
+    auto &queue = *m_devices[deviceIndex].Submissions;
+    {
+        std::lock_guard<std::mutex> lock(queue.Mutex);
+        submission.Sequence = queue.NextSequence++;
+        try
+        {
+            queue.Pending.push(std::move(submission));
+        }
+        catch (const std::bad_alloc &ex)
+        {
+            std::cout << " Error bad allocation caught in " << __FILE__ << " at line " << __LINE__ << endl;
+            std::cout << " Exception: " << ex.what() << endl;
+            std::terminate();
+        }
+    }
+    queue.Condition.notify_one();
+}
+
+AsyncDirectoryWalker::Submission AsyncDirectoryWalker::Dequeue(size_t deviceIndex)
+{
+    auto &queue = *m_devices[deviceIndex].Submissions;
+    std::unique_lock<std::mutex> lock(queue.Mutex);
+    while (queue.Pending.empty())
+    {
+        queue.Condition.wait(lock);
+    }
+    Submission submission = queue.Pending.top();
+    queue.Pending.pop();
+    return submission;
+}
+
+void AsyncDirectoryWalker::Submit(const std::string &directory, size_t tag /*= 0*/, size_t deviceIndex /*= 0*/)
+{
+    m_outstandingReads++;
+
+    Submission submission;
+    submission.Directory = directory;
+    submission.Tag = tag;
+    submission.Preferred = (m_options.Order == TraversalOrder::Priority) && IsPreferred(directory);
+    Enqueue(deviceIndex, std::move(submission));
+}
+
+void AsyncDirectoryWalker::SubmitSubdirectory(const Completion &parent, const std::string &directory, size_t tag /*= 0*/)
+{
+    m_outstandingReads++;
+
+    // Everything under a preferred directory is preferred too, so only directories outside them need checking
+    Submission submission;
+    submission.Directory = directory;
+    submission.Tag = tag;
+    submission.Depth = parent.Depth + 1;
+    submission.Preferred = parent.Preferred || ((m_options.Order == TraversalOrder::Priority) && IsPreferred(directory));
+    Enqueue(parent.DeviceIndex, std::move(submission));
+}
+
+bool AsyncDirectoryWalker::NextCompletion(Completion &completion)
+{
+    auto next = m_completions->Dequeue();
+    if (next == nullptr || m_terminate)
+    {
+        return false;
+    }
+
+    m_outstandingReads--;
+    completion = std::move(*next);
+    return true;
+}
+
+AsyncDirectoryWalker::WaitStatus AsyncDirectoryWalker::NextCompletion(Completion &completion, std::chrono::steady_clock::duration timeout)
+{
+    std::shared_ptr<Completion> next;
+    if (!m_completions->TryDequeue(next, timeout))
+    {
+        return WaitStatus::TimedOut;
+    }
+    if (next == nullptr || m_terminate)
+    {
+        return WaitStatus::Stopped;
+    }
+
+    m_outstandingReads--;
+    completion = std::move(*next);
+    return WaitStatus::Completed;
+}
+
+int AsyncDirectoryWalker::OutstandingReads() const
+{
+    return m_outstandingReads;
+}
+
+void AsyncDirectoryWalker::Stop()
+{
+    if (m_terminate.exchange(true))
+    {
+        return;
+    }
+
+    // Wake every I/O thread blocked on the submission queue, and any consumer blocked on the completion queue.
+    for (auto &device : m_devices)
+    {
+        for (int ix = 0; ix < device.QueueDepth; ix++)
+        {
+            {
+                std::lock_guard<std::mutex> lock(device.Submissions->Mutex);
+                device.Submissions->Pending.push(Submission());
+            }
+            device.Submissions->Condition.notify_all();
+        }
+    }
+    m_completions->Enqueue(nullptr);
+}
+
+const ConcurrentIdentitySet *AsyncDirectoryWalker::VisitedDirectories() const
+{
+    return m_visitedDirectories.get();
+}
+
+const ConcurrentIdentitySet *AsyncDirectoryWalker::SeenHardlinks() const
+{
+    return m_seenHardlinks.get();
+}
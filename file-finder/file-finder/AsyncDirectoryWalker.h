@@ -0,0 +1,184 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include "WalkOptions.h"
+
+namespace fileFinder
+{
+    template <typename T>
+    class ThreadSafeQueue;
+    class ConcurrentIdentitySet;
+
+    /// AsyncDirectoryWalker keeps up to a fixed number of directory reads in flight at once, so that on network filesystems and cold caches the walk
+    /// isn't limited by the latency of a single blocking readdir/stat at a time. Directories are submitted to a submission queue, serviced by a pool
+    /// of I/O threads (one per slot of queue depth), and the entries they read are handed back through a completion queue.
+    /// Each device (disk, mount, or network share) has its own submission queue and its own pool of I/O threads, so a slow device can only ever
+    /// tie up its own threads, while completions from every device are handed back through the one shared completion queue.
+    /// Each device's waiting directories are kept in priority order, so the walk can be depth first, breadth first, or visit preferred directories first
+    /// @see TraversalOrder. When following symbolic links, the I/O threads share a set of every directory read so far, and a directory reached a second time completes
+    /// without being read again.
+    /// sample usage:
+    /// AsyncDirectoryWalker walker(options);
+    /// auto device = walker.AddDevice(deviceId, 16);
+    /// walker.Start();
+    /// walker.Submit(path, 0, device);
+    /// AsyncDirectoryWalker::Completion completion;
+    /// while (walker.OutstandingReads() > 0 && walker.NextCompletion(completion)) { ... walker.SubmitSubdirectory(completion, subdirectory, tag) ... }
+    class AsyncDirectoryWalker
+    {
+    public:
+        /// A single entry read from a directory, along with the result of the stat call made for it by the I/O thread.
+        struct Entry
+        {
+            std::string Name;
+            std::string Path;
+            bool IsDirectory{ false };
+            /// The type of the entry itself, without following it if it's a symbolic link
+            std::filesystem::file_type LinkType{ std::filesystem::file_type::none };
+            /// True if this is a directory on a different device to the one being walked, only checked when the walker stays on one file system
+            bool OnOtherDevice{ false };
+            /// True if this is a hard link to a file already returned by the walker, only checked when duplicate hard links are suppressed
+            bool IsDuplicateLink{ false };
+        };
+
+        /// The result of reading one directory that was passed to @see AsyncDirectoryWalker::Submit
+        struct Completion
+        {
+            std::string Directory;
+            size_t Tag{ 0 };
+            size_t DeviceIndex{ 0 };
+            /// The number of directories between this one and the root it was found under
+            size_t Depth{ 0 };
+            /// True if this directory is at or under one of @see WalkOptions::PreferredDirectories
+            bool Preferred{ false };
+            std::vector<Entry> Entries;
+            std::string Error;
+            /// True if the directory had already been read through another path, in which case it has no entries
+            bool AlreadyVisited{ false };
+        };
+
+        /// The outcome of waiting for a completion with a timeout
+        enum class WaitStatus
+        {
+            Completed,
+            TimedOut,
+            Stopped
+        };
+
+    private:
+        /// Directories that aren't preferred are read after every preferred directory, however deep
+        static constexpr int64_t NOT_PREFERRED_PENALTY{ int64_t(1) << 32 };
+
+        /// A directory waiting to be read, along with the consumer's tag for it
+        struct Submission
+        {
+            std::string Directory;
+            size_t Tag{ 0 };
+            size_t Depth{ 0 };
+            bool Preferred{ false };
+            /// Submissions with a lower key are read first, and those with the same key in the order they were submitted
+            int64_t Key{ 0 };
+            uint64_t Sequence{ 0 };
+        };
+
+        /// Orders a priority_queue so the submission with the lowest key (and then the lowest sequence number) is on top
+        struct ReadLater
+        {
+            bool operator()(const Submission &left, const Submission &right) const
+            {
+                return (left.Key != right.Key) ? left.Key > right.Key : left.Sequence > right.Sequence;
+            }
+        };
+
+        /// The directories waiting to be read on a device, I/O threads block on the condition until there is one
+        struct SubmissionQueue
+        {
+            std::mutex Mutex;
+            std::condition_variable Condition;
+            std::priority_queue<Submission, std::vector<Submission>, ReadLater> Pending;
+            uint64_t NextSequence{ 0 };
+        };
+
+        /// A device's identity, its share of I/O threads, and the directories waiting for them
+        struct Device
+        {
+            uint64_t Id{ 0 };
+            int QueueDepth{ 1 };
+            std::unique_ptr<SubmissionQueue> Submissions;
+        };
+
+        WalkOptions m_options;
+        std::unique_ptr<ConcurrentIdentitySet> m_visitedDirectories;
+        std::unique_ptr<ConcurrentIdentitySet> m_seenHardlinks;
+        std::atomic<bool> m_terminate{ false };
+        std::atomic<int> m_outstandingReads{ 0 };
+        std::vector<Device> m_devices;
+        std::unique_ptr<ThreadSafeQueue<std::shared_ptr<Completion>>> m_completions;
+        std::vector<std::unique_ptr<std::thread>> m_ioThreads;
+
+        /// Function to be run as a thread that services directory reads from the device's submission queue until the walker is stopped.
+        void ServiceSubmissions(size_t deviceIndex);
+
+        /// Returns true if directory is one of the preferred directories or, for hints that are a name rather than a path, has that name
+        bool IsPreferred(const std::string &directory) const;
+
+        /// Works out when the submission should be read for the traversal order selected, and adds it to the device's queue.
+        void Enqueue(size_t deviceIndex, Submission submission);
+
+        /// Blocks until the device has a directory waiting to be read, then removes and returns the first one.
+        Submission Dequeue(size_t deviceIndex);
+
+    public:
+
+        /// Only the options that affect how a single directory is read are used (OneFileSystem, FollowSymlinks, and DedupeHardlinks), the queue
+        /// depth is given for each device by @see AsyncDirectoryWalker::AddDevice
+        explicit AsyncDirectoryWalker(const WalkOptions &options = WalkOptions());
+
+        /// Copying this object is not part of our use case, so we'll set it up as non-copyable
+        AsyncDirectoryWalker& operator=(const AsyncDirectoryWalker&) = delete;
+
+        /// Stops and joins the I/O threads if the consumer hasn't already done so.
+        ~AsyncDirectoryWalker();
+
+        /// Adds a device that may have up to queueDepth directory reads in flight at once (values less than one are treated as one), returning the
+        /// index used to submit directories to it. Devices must all be added before Start is called.
+        size_t AddDevice(uint64_t deviceId, int queueDepth);
+
+        /// Starts the I/O threads that service submitted directory reads.
+        void Start();
+
+        /// Queues a root directory on the device specified to be read, the result will be returned by a later call to @see AsyncDirectoryWalker::NextCompletion
+        /// The tag is opaque to the walker and is returned unchanged in the completion, so consumers can tie it back to their own state.
+        void Submit(const std::string &directory, size_t tag = 0, size_t deviceIndex = 0);
+
+        /// Queues a subdirectory found in parent to be read, on the same device and one level deeper.
+        void SubmitSubdirectory(const Completion &parent, const std::string &directory, size_t tag = 0);
+
+        /// Blocks until a directory read completes and returns it in completion. Returns false if the walker has been stopped.
+        bool NextCompletion(Completion &completion);
+
+        /// Blocks for at most timeout until a directory read completes and returns it in completion, @see AsyncDirectoryWalker::WaitStatus
+        WaitStatus NextCompletion(Completion &completion, std::chrono::steady_clock::duration timeout);
+
+        /// Returns the number of submitted directories whose completion hasn't yet been returned by NextCompletion, once this reaches zero the walk is done.
+        int OutstandingReads() const;
+
+        /// Terminates the I/O threads, any reads that are still queued are abandoned.
+        void Stop();
+
+        /// Returns the set of directories read so far, or nullptr if symbolic links aren't followed
+        const ConcurrentIdentitySet *VisitedDirectories() const;
+
+        /// Returns the set of files with more than one hard link seen so far, or nullptr if duplicate hard links aren't suppressed
+        const ConcurrentIdentitySet *SeenHardlinks() const;
+    };
+}
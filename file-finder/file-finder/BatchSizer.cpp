@@ -0,0 +1,63 @@
+#include <algorithm>
+#include "BatchSizer.h"
+
+using namespace std;
+using namespace fileFinder;
+
+BatchSizer::BatchSizer()
+{
+    m_statistics.SmallestLimit = m_limit;
+    m_statistics.LargestLimit = m_limit;
+    m_statistics.FinalLimit = m_limit;
+}
+
+size_t BatchSizer::Limit() const
+{
+    return m_limit;
+}
+
+void BatchSizer::Record(size_t names, size_t bytes, size_t buffersWaiting)
+{
+    m_statistics.Batches++;
+    m_statistics.Names += static_cast<int64_t>(names);
+    if (names == 0)
+    {
+        return;
+    }
+
+    // Weight recent batches more heavily, since name lengths vary from one part of a tree to another
+    double bytesPerName = static_cast<double>(bytes) / static_cast<double>(names);
+    m_bytesPerName = (m_bytesPerName == 0.0) ? bytesPerName : (m_bytesPerName * 0.75 + bytesPerName * 0.25);
+    size_t byteLimit = std::max<size_t>(MIN_LIMIT, std::min<size_t>(MAX_LIMIT, static_cast<size_t>(TARGET_BATCH_BYTES / std::max(m_bytesPerName, 1.0))));
+
+    size_t limit = m_limit;
+    if (buffersWaiting >= BACKED_UP_BACKLOG)
+    {
+        limit = std::max(MIN_LIMIT, limit / 2);
+    }
+    else if (buffersWaiting <= KEEPING_UP_BACKLOG)
+    {
+        limit = std::min(byteLimit, limit * 2);
+    }
+
+    // Names may have grown longer since the limit was last raised, so the byte target is enforced whichever way the backlog points
+    limit = std::min(limit, byteLimit);
+
+    if (limit > m_limit)
+    {
+        m_statistics.Grew++;
+    }
+    else if (limit < m_limit)
+    {
+        m_statistics.Shrank++;
+    }
+    m_limit = limit;
+    m_statistics.SmallestLimit = std::min(m_statistics.SmallestLimit, m_limit);
+    m_statistics.LargestLimit = std::max(m_statistics.LargestLimit, m_limit);
+    m_statistics.FinalLimit = m_limit;
+}
+
+const BatchSizer::Statistics &BatchSizer::Stats() const
+{
+    return m_statistics;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace fileFinder
+{
+    /// BatchSizer chooses how many file names @see FileNameBuffer puts in each buffer before handing it to the search threads. Batches start small
+    /// so the first matches show up quickly, double while the search threads keep up (few buffers waiting to be searched), up to a number of names
+    /// that fills roughly TARGET_BATCH_BYTES, and halve when the search threads fall behind and buffers back up.
+    /// sample usage:
+    /// BatchSizer sizer;
+    /// if (buffer.size() >= sizer.Limit()) { sizer.Record(buffer.size(), bufferBytes, buffersWaiting); ... hand off buffer ... }
+    class BatchSizer
+    {
+    public:
+        /// How the batch size limit behaved over a walk
+        struct Statistics
+        {
+            int64_t Batches{ 0 };
+            int64_t Names{ 0 };
+            size_t SmallestLimit{ 0 };
+            size_t LargestLimit{ 0 };
+            size_t FinalLimit{ 0 };
+            int64_t Grew{ 0 };
+            int64_t Shrank{ 0 };
+        };
+
+    private:
+        static constexpr size_t INITIAL_LIMIT{ 64 };
+        static constexpr size_t MIN_LIMIT{ 32 };
+        static constexpr size_t MAX_LIMIT{ 64 * 1024 };
+        static constexpr size_t TARGET_BATCH_BYTES{ 128 * 1024 };
+
+        /// The search threads are keeping up while no more than this many buffers are waiting for them, so batches may grow
+        static constexpr size_t KEEPING_UP_BACKLOG{ 4 };
+
+        /// The search threads have fallen behind once this many buffers are waiting for them, so batches shrink
+        static constexpr size_t BACKED_UP_BACKLOG{ 32 };
+
+        size_t m_limit{ INITIAL_LIMIT };
+        /// Running average of the bytes each name (and its path, if collected) takes, used to turn the byte target into a number of names
+        double m_bytesPerName{ 0.0 };
+        Statistics m_statistics;
+
+    public:
+        BatchSizer();
+
+        /// Returns the number of names a buffer should hold before it's handed off
+        size_t Limit() const;
+
+        /// Records a buffer of names taking bytes being handed off while buffersWaiting buffers are still waiting to be searched, and adjusts the limit
+        void Record(size_t names, size_t bytes, size_t buffersWaiting);
+
+        /// Returns how the limit has behaved so far
+        const Statistics &Stats() const;
+    };
+}
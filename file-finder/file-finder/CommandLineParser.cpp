@@ -1,4 +1,5 @@
 #include "CommandLineParser.h"
+#include "FileIdentity.h"
 #include <vector>
 #include <string>
 #include <filesystem>
@@ -11,35 +12,79 @@ using namespace fileFinder;
 
 void CommandLineParser::ParseCommandLine(int argc, char *argv[])
 {
-    if (argc <= 1)
+    // Options may appear anywhere on the command line, everything else is positional (the path followed by the substrings)
+    std::vector<std::string> positional;
+    for (int ix = 1; ix < argc; ix++)
     {
-        m_errorString = "Error: " + STR_PLEASE_SPECIFY + "\n" + STR_SAMPLE_USAGE;
+        std::string argument = argv[ix];
+        if (argument.rfind("--", 0) == 0)
+        {
+            if (!ParseOption(argument))
+            {
+                return;
+            }
+        }
+        else
+        {
+            positional.push_back(argument);
+        }
     }
-    else if (argc == 2)
+
+    size_t requiredArguments = m_benchmark ? 1 : 2;
+    if (positional.size() < requiredArguments)
     {
         m_errorString = "Error: " + STR_PLEASE_SPECIFY + "\n" + STR_SAMPLE_USAGE;
     }
-    else // if (argc >= 3)
+    else
     {
         // Ensure we have valid parameters, and then parse the parameters accordingly.
-        if (!exists(argv[1]))
+        m_roots.insert(m_roots.begin(), positional[0]);
+        for (auto &root : m_roots)
         {
-            m_errorString = "Error: The path specified does not exist.\n" + STR_SAMPLE_USAGE;
+            if (!ValidateDirectory(root))
+            {
+                return;
+            }
+        }
+
+        if (m_searchOptions.Content && m_searchOptions.MaxEditDistance >= 0)
+        {
+            m_errorString = "Error: --fuzzy can only be used to search file names, not with --content.\n" + STR_SAMPLE_USAGE;
             return;
         }
-        if (!is_directory(argv[1]))
+        if (m_searchOptions.MultiPattern && m_searchOptions.MaxEditDistance >= 0)
         {
-            m_errorString = "Error: The path specified is not a directory.\n" + STR_SAMPLE_USAGE;
+            m_errorString = "Error: --fuzzy ranks each substring separately and can't be used with --multi-pattern.\n" + STR_SAMPLE_USAGE;
             return;
         }
 
-        m_path = argv[1];
+        if (m_searchOptions.Sorted && m_searchOptions.MaxEditDistance >= 0)
+        {
+            m_errorString = "Error: --fuzzy results are ranked by edit distance and can't be used with --sorted.\n" + STR_SAMPLE_USAGE;
+            return;
+        }
 
-        for (int ix = 2; ix < argc; ix++)
+        if (!m_walkOptions.PreferredDirectories.empty() && m_walkOptions.Order != TraversalOrder::Priority)
+        {
+            m_errorString = "Error: --prefer can only be used with --order=priority.\n" + STR_SAMPLE_USAGE;
+            return;
+        }
+
+        // The compact tree is built from whole directory listings, and directories can only be read out of depth first order, by the asynchronous walker
+        bool requiresAsyncWalker = m_walkOptions.CompactTree || m_walkOptions.Order != TraversalOrder::DepthFirst;
+        if (m_queueDepth.has_value() && *m_queueDepth == 0 && requiresAsyncWalker)
+        {
+            m_errorString = "Error: --compact-tree and --order=breadth|priority need the asynchronous walker, and can't be used with --queue-depth=0.\n" + STR_SAMPLE_USAGE;
+            return;
+        }
+
+        m_path = positional[0];
+
+        for (size_t ix = 1; ix < positional.size(); ix++)
         {
             try
             {
-                m_needles.push_back(argv[ix]);
+                m_needles.push_back(positional[ix]);
             }
             catch (const std::bad_alloc &ex)
             {
@@ -49,10 +94,206 @@ void CommandLineParser::ParseCommandLine(int argc, char *argv[])
             }
         }
 
+        // Reading a file costs far more than matching it, so content searches always look for every needle in a single read of each file
+        if (m_searchOptions.Content)
+        {
+            m_searchOptions.MultiPattern = true;
+        }
+
+        // Content searches need the full path of every file name to open it, and sorted and fuzzy searches report full paths
+        m_walkOptions.CollectPaths = m_searchOptions.Content || m_searchOptions.Sorted || m_searchOptions.MaxEditDistance >= 0;
+
+        // Without --queue-depth we pick the walker: roots on different devices are only walked side by side (rather than one after another) by the
+        // asynchronous walker. An explicit --queue-depth=0 always gets the synchronous walker, so it can be compared against the asynchronous one.
+        if (m_queueDepth.has_value())
+        {
+            m_walkOptions.QueueDepth = *m_queueDepth;
+        }
+        else if (requiresAsyncWalker || RootsSpanDevices())
+        {
+            m_walkOptions.QueueDepth = 1;
+        }
+
         m_isValid = true;
     }
 }
 
+bool CommandLineParser::ParseOption(const std::string &option)
+{
+    auto separator = option.find('=');
+    std::string name = option.substr(0, separator);
+    std::string value = (separator == std::string::npos) ? "" : option.substr(separator + 1);
+
+    if (name == "--queue-depth")
+    {
+        int queueDepth = 0;
+        if (!ParseNonNegativeInteger(name, value, queueDepth))
+        {
+            return false;
+        }
+        m_queueDepth = queueDepth;
+        return true;
+    }
+    else if (name == "--content")
+    {
+        m_searchOptions.Content = true;
+        return true;
+    }
+    else if (name == "--fuzzy")
+    {
+        return ParseNonNegativeInteger(name, value, m_searchOptions.MaxEditDistance);
+    }
+    else if (name == "--top")
+    {
+        return ParseNonNegativeInteger(name, value, m_searchOptions.TopK);
+    }
+    else if (name == "--ignore-case")
+    {
+        m_searchOptions.IgnoreCase = true;
+        return true;
+    }
+    else if (name == "--multi-pattern")
+    {
+        m_searchOptions.MultiPattern = true;
+        return true;
+    }
+    else if (name == "--result-memory")
+    {
+        return ParseNonNegativeInteger(name, value, m_searchOptions.ResultMemoryMB);
+    }
+    else if (name == "--sorted")
+    {
+        m_searchOptions.Sorted = true;
+        return true;
+    }
+    else if (name == "--compact-tree")
+    {
+        m_walkOptions.CompactTree = true;
+        return true;
+    }
+    else if (name == "--order")
+    {
+        if (value == "depth")
+        {
+            m_walkOptions.Order = TraversalOrder::DepthFirst;
+        }
+        else if (value == "breadth")
+        {
+            m_walkOptions.Order = TraversalOrder::BreadthFirst;
+        }
+        else if (value == "priority")
+        {
+            m_walkOptions.Order = TraversalOrder::Priority;
+        }
+        else
+        {
+            m_errorString = "Error: --order must be one of depth, breadth, or priority.\n" + STR_SAMPLE_USAGE;
+            return false;
+        }
+        return true;
+    }
+    else if (name == "--prefer")
+    {
+        if (value.empty())
+        {
+            m_errorString = "Error: --prefer requires a directory path or name.\n" + STR_SAMPLE_USAGE;
+            return false;
+        }
+        m_walkOptions.PreferredDirectories.push_back(value);
+        return true;
+    }
+    else if (name == "--root")
+    {
+        if (value.empty())
+        {
+            m_errorString = "Error: --root requires a path.\n" + STR_SAMPLE_USAGE;
+            return false;
+        }
+        m_roots.push_back(value);
+        return true;
+    }
+    else if (name == "--one-file-system")
+    {
+        m_walkOptions.OneFileSystem = true;
+        return true;
+    }
+    else if (name == "--follow-symlinks")
+    {
+        m_walkOptions.FollowSymlinks = true;
+        return true;
+    }
+    else if (name == "--dedupe-hardlinks")
+    {
+        m_walkOptions.DedupeHardlinks = true;
+        return true;
+    }
+    else if (name == "--benchmark")
+    {
+        m_benchmark = true;
+        return true;
+    }
+
+    m_errorString = "Error: Unknown option " + name + "\n" + STR_SAMPLE_USAGE;
+    return false;
+}
+
+bool CommandLineParser::ValidateDirectory(const std::string &path)
+{
+    if (!exists(path))
+    {
+        m_errorString = "Error: The path specified does not exist: " + path + "\n" + STR_SAMPLE_USAGE;
+        return false;
+    }
+    if (!is_directory(path))
+    {
+        m_errorString = "Error: The path specified is not a directory: " + path + "\n" + STR_SAMPLE_USAGE;
+        return false;
+    }
+    return true;
+}
+
+bool CommandLineParser::RootsSpanDevices() const
+{
+    bool haveDevice = false;
+    uint64_t device = 0;
+    for (auto &root : m_roots)
+    {
+        FileIdentity identity;
+        if (!QueryFileIdentity(root, identity))
+        {
+            continue;
+        }
+        if (haveDevice && identity.Device != device)
+        {
+            return true;
+        }
+        haveDevice = true;
+        device = identity.Device;
+    }
+    return false;
+}
+
+bool CommandLineParser::ParseNonNegativeInteger(const std::string &name, const std::string &value, int &result)
+{
+    try
+    {
+        size_t parsedLength = 0;
+        int parsed = std::stoi(value, &parsedLength);
+        if (parsedLength == value.size() && parsed >= 0)
+        {
+            result = parsed;
+            return true;
+        }
+    }
+    catch (const std::exception &)
+    {
+        // Fall through to the error below, std::stoi throws for empty, non-numeric, and out of range values
+    }
+
+    m_errorString = "Error: " + name + " requires a non-negative integer value.\n" + STR_SAMPLE_USAGE;
+    return false;
+}
+
 CommandLineParser::CommandLineParser(int argc, char *argv[])
 {
     ParseCommandLine(argc, argv);
@@ -68,6 +309,11 @@ std::string CommandLineParser::Path() const
     return m_path;
 }
 
+std::vector<std::string> CommandLineParser::Roots() const
+{
+    return m_roots;
+}
+
 std::vector<std::string> CommandLineParser::Needles() const
 {
     return m_needles;
@@ -77,3 +323,18 @@ std::string CommandLineParser::ErrorString()  const
 {
     return m_errorString;
 }
+
+WalkOptions CommandLineParser::WalkSettings() const
+{
+    return m_walkOptions;
+}
+
+bool CommandLineParser::Benchmark() const
+{
+    return m_benchmark;
+}
+
+SearchOptions CommandLineParser::SearchSettings() const
+{
+    return m_searchOptions;
+}
@@ -2,6 +2,9 @@
 #include <vector>
 #include <string>
 #include <filesystem>
+#include <optional>
+#include "WalkOptions.h"
+#include "SearchOptions.h"
 
 namespace fileFinder
 {
@@ -18,13 +21,31 @@ namespace fileFinder
     private:
         std::vector<std::string> m_needles;
         std::string m_path {""};
+        std::vector<std::string> m_roots;
         std::string m_errorString {""};
         bool m_isValid {false};
-        const std::string STR_SAMPLE_USAGE {"Sample usage: file-finder.exe path <substring1> [<substring2> [<substring3>] ...]"};
+        bool m_benchmark {false};
+        WalkOptions m_walkOptions;
+        SearchOptions m_searchOptions;
+        /// The value given with --queue-depth, if it was given at all, so an explicit 0 (the synchronous walker) is never overridden
+        std::optional<int> m_queueDepth;
+        const std::string STR_SAMPLE_USAGE {"Sample usage: file-finder.exe [--queue-depth=<n>] [--benchmark] [--content] [--fuzzy=<k> [--top=<n>]] [--ignore-case] [--multi-pattern] [--result-memory=<MB>] [--sorted] [--compact-tree] [--order=depth|breadth|priority [--prefer=<dir> ...]] [--one-file-system] [--follow-symlinks] [--dedupe-hardlinks] [--root=<path> ...] path <substring1> [<substring2> [<substring3>] ...]"};
         const std::string STR_PLEASE_SPECIFY {"Please specify both a path and at least one substring to search for."};
 
         ///  Handles parsing of command line arguments and sets object properties accordingly.
         void ParseCommandLine(int argc, char *argv[]);
+
+        ///  Handles parsing of a single, "--name[=value]" option, returning false and setting the error string if it isn't valid.
+        bool ParseOption(const std::string &option);
+
+        ///  Returns false and sets the error string if path isn't an existing directory.
+        bool ValidateDirectory(const std::string &path);
+
+        ///  Returns true if the roots live on more than one device.
+        bool RootsSpanDevices() const;
+
+        ///  Parses value as a non-negative integer for the option name specified, returning false and setting the error string if it isn't valid.
+        bool ParseNonNegativeInteger(const std::string &name, const std::string &value, int &result);
     public:
 
         CommandLineParser() = delete;
@@ -37,9 +58,21 @@ namespace fileFinder
         /// If command line parsed successfully returns the path parameter, otherwise returns an empty string
         std::string Path() const;
 
+        /// Returns every root path to search, the path parameter followed by any specified with --root=<path>
+        std::vector<std::string> Roots() const;
+
         /// Returns the number of substrings specified on the command line that we will use to find the, "needles" in our haystacks 
         std::vector<std::string> Needles() const;
 
+        /// Returns the filesystem enumeration options specified on the command line, e.g. --queue-depth=16
+        WalkOptions WalkSettings() const;
+
+        /// Returns the search options specified on the command line, e.g. --content or --fuzzy=2
+        SearchOptions SearchSettings() const;
+
+        /// Returns true if --benchmark was specified, in which case the path is enumerated without searching and no substrings are required
+        bool Benchmark() const;
+
         /// If Parse has returned false, will contain error string that can be dipslayed to user
         std::string ErrorString() const;
     };
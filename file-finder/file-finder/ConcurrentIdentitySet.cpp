@@ -0,0 +1,121 @@
+#include <iostream>
+#include "ConcurrentIdentitySet.h"
+
+using namespace std;
+using namespace fileFinder;
+
+ConcurrentIdentitySet::ConcurrentIdentitySet(size_t concurrency)
+{
+    // Round the shard count up to a power of two so a shard can be selected with a shift
+    size_t wantedShards = (concurrency < 1 ? 1 : concurrency) * SHARDS_PER_THREAD;
+    while (m_shardCount < wantedShards)
+    {
+        m_shardCount <<= 1;
+        m_shardBits++;
+    }
+    m_shards = std::make_unique<Shard[]>(m_shardCount);
+}
+
+uint64_t ConcurrentIdentitySet::Hash(const Key &key)
+{
+    // splitmix64's finalizer, file indexes are often sequential so they need mixing before their low bits are any use
+    uint64_t hash = key.Index ^ (key.Device * 0x9E3779B97F4A7C15ULL);
+    hash ^= hash >> 30;
+    hash *= 0xBF58476D1CE4E5B9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94D049BB133111EBULL;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+bool ConcurrentIdentitySet::InsertIntoSlots(std::vector<Key> &slots, const Key &key, uint64_t hash)
+{
+    size_t mask = slots.size() - 1;
+    for (size_t slot = static_cast<size_t>(hash) & mask; ; slot = (slot + 1) & mask)
+    {
+        auto &existing = slots[slot];
+        if (existing.Device == key.Device && existing.Index == key.Index)
+        {
+            return false;
+        }
+        if (existing.Device == 0 && existing.Index == 0)
+        {
+            existing = key;
+            return true;
+        }
+    }
+}
+
+void ConcurrentIdentitySet::Grow(Shard &shard)
+{
+    std::vector<Key> slots;
+    try
+    {
+        slots.resize(shard.Slots.empty() ? INITIAL_SLOTS : shard.Slots.size() * 2);
+    }
+    catch (const std::bad_alloc &ex)
+    {
+        std::cout << " Error bad allocation caught in " << __FILE__ << " at line " << __LINE__ << endl;
+        std::cout << " Exception: " << ex.what() << endl;
+        std::terminate();
+    }
+
+    for (auto &key : shard.Slots)
+    {
+        if (key.Device != 0 || key.Index != 0)
+        {
+            InsertIntoSlots(slots, key, Hash(key));
+        }
+    }
+    shard.Slots.swap(slots);
+}
+
+bool ConcurrentIdentitySet::Insert(const FileIdentity &identity)
+{
+    Key key{ identity.Device, identity.Index };
+    uint64_t hash = Hash(key);
+    auto &shard = m_shards[m_shardBits == 0 ? 0 : static_cast<size_t>(hash >> (64 - m_shardBits))];
+
+    std::lock_guard<std::mutex> lock(shard.Mutex);
+    if (key.Device == 0 && key.Index == 0)
+    {
+        bool inserted = !shard.ContainsZeroKey;
+        shard.ContainsZeroKey = true;
+        return inserted;
+    }
+
+    // Keep the table at most three quarters full so probe sequences stay short
+    if ((shard.Count + 1) * 4 > shard.Slots.size() * 3)
+    {
+        Grow(shard);
+    }
+
+    if (InsertIntoSlots(shard.Slots, key, hash))
+    {
+        shard.Count++;
+        return true;
+    }
+    return false;
+}
+
+size_t ConcurrentIdentitySet::Size() const
+{
+    size_t size = 0;
+    for (size_t ix = 0; ix < m_shardCount; ix++)
+    {
+        std::lock_guard<std::mutex> lock(m_shards[ix].Mutex);
+        size += m_shards[ix].Count + (m_shards[ix].ContainsZeroKey ? 1 : 0);
+    }
+    return size;
+}
+
+size_t ConcurrentIdentitySet::MemoryUsage() const
+{
+    size_t bytes = m_shardCount * sizeof(Shard);
+    for (size_t ix = 0; ix < m_shardCount; ix++)
+    {
+        std::lock_guard<std::mutex> lock(m_shards[ix].Mutex);
+        bytes += m_shards[ix].Slots.capacity() * sizeof(Key);
+    }
+    return bytes;
+}
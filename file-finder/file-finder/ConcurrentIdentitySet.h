@@ -0,0 +1,69 @@
+#pragma once
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <cstdint>
+#include "FileIdentity.h"
+
+namespace fileFinder
+{
+    /// ConcurrentIdentitySet records which files (by device and file index) have been seen, so that a walk can tell when it reaches the same
+    /// directory or hard linked file through a second path. The set is split into shards, each an open addressed table of 16 byte keys guarded
+    /// by its own lock, and the number of shards grows with the number of threads inserting into it so they rarely contend for the same lock.
+    /// sample usage:
+    /// ConcurrentIdentitySet visited(threadCount);
+    /// if (QueryFileIdentity(path, identity) && visited.Insert(identity)) { ... first time we've seen this file ... }
+    class ConcurrentIdentitySet
+    {
+    private:
+        static constexpr size_t SHARDS_PER_THREAD{ 4 };
+        static constexpr size_t INITIAL_SLOTS{ 16 };
+
+        struct Key
+        {
+            uint64_t Device{ 0 };
+            uint64_t Index{ 0 };
+        };
+
+        /// Each shard sits on its own cache line so threads working on neighbouring shards don't invalidate each other's lock
+        struct alignas(64) Shard
+        {
+            std::mutex Mutex;
+            std::vector<Key> Slots;
+            size_t Count{ 0 };
+            // A zeroed key marks an empty slot, so a genuine zero key is tracked separately
+            bool ContainsZeroKey{ false };
+        };
+
+        std::unique_ptr<Shard[]> m_shards;
+        size_t m_shardCount{ 1 };
+        int m_shardBits{ 0 };
+
+        /// Mixes the device and file index into 64 bits, the high bits select the shard and the low bits the slot within it
+        static uint64_t Hash(const Key &key);
+
+        /// Inserts key into slots, which must have room for it, returning false if it was already present
+        static bool InsertIntoSlots(std::vector<Key> &slots, const Key &key, uint64_t hash);
+
+        /// Doubles the number of slots in the shard and reinserts its keys
+        static void Grow(Shard &shard);
+
+    public:
+        /// Creates a set sized for up to concurrency threads inserting at once
+        explicit ConcurrentIdentitySet(size_t concurrency);
+
+        ConcurrentIdentitySet() = delete;
+
+        /// Copying this object is not part of our use case, so we'll set it up as non-copyable
+        ConcurrentIdentitySet& operator=(const ConcurrentIdentitySet&) = delete;
+
+        /// Adds the file's device and index to the set, returning true if it wasn't already present. Safe to call from any number of threads.
+        bool Insert(const FileIdentity &identity);
+
+        /// Returns the number of identities in the set.
+        size_t Size() const;
+
+        /// Returns the number of bytes allocated by the set.
+        size_t MemoryUsage() const;
+    };
+}
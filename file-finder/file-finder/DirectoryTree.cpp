@@ -0,0 +1,300 @@
+#include <iostream>
+#include <bitset>
+#include <filesystem>
+#include <algorithm>
+#include "DirectoryTree.h"
+
+using namespace std;
+using namespace fileFinder;
+
+void DirectoryTree::RankedBitVector::Append(bool bit)
+{
+    if (Size % 64 == 0)
+    {
+        // Starting a new word, so record how many bits were set in all of the words before it
+        uint32_t rank = Words.empty() ? 0 : RankBeforeWord.back() + static_cast<uint32_t>(std::bitset<64>(Words.back()).count());
+        Words.push_back(0);
+        RankBeforeWord.push_back(rank);
+    }
+    if (bit)
+    {
+        Words.back() |= (uint64_t(1) << (Size % 64));
+    }
+    Size++;
+}
+
+bool DirectoryTree::RankedBitVector::Get(size_t index) const
+{
+    return (Words[index / 64] >> (index % 64)) & 1;
+}
+
+size_t DirectoryTree::RankedBitVector::Rank(size_t index) const
+{
+    size_t word = index / 64;
+    size_t bit = index % 64;
+    uint64_t mask = (bit == 0) ? 0 : (~uint64_t(0) >> (64 - bit));
+    return RankBeforeWord[word] + std::bitset<64>(Words[word] & mask).count();
+}
+
+size_t DirectoryTree::RankedBitVector::NextSetBit(size_t index) const
+{
+    for (size_t word = index / 64; word < Words.size(); word++)
+    {
+        uint64_t bits = Words[word];
+        if (word == index / 64)
+        {
+            bits &= (~uint64_t(0) << (index % 64));
+        }
+        if (bits != 0)
+        {
+            size_t offset = 0;
+            while (((bits >> offset) & 1) == 0)
+            {
+                offset++;
+            }
+            return std::min(Size, word * 64 + offset);
+        }
+    }
+    return Size;
+}
+
+size_t DirectoryTree::RankedBitVector::MemoryUsage() const
+{
+    return Words.capacity() * sizeof(uint64_t) + RankBeforeWord.capacity() * sizeof(uint32_t);
+}
+
+DirectoryTree::DirectoryTree(const std::string &rootPath) :
+    m_rootPath(rootPath)
+{
+    // The root has no parent, we store zero for it and special case it in Parent()
+    Append(0, rootPath, ENTRY_DIRECTORY, true);
+}
+
+void DirectoryTree::WriteRecord(bool startsBlock)
+{
+    if (m_nameChunks.empty() || m_nameChunks.back().Used + m_record.size() > m_nameChunks.back().Capacity)
+    {
+        // Blocks can't span chunks, so an unfinished block comes with us to the new chunk. Readers that already have its old address can still
+        // decode the names it held from there, since old chunks are never changed or freed.
+        const char *carriedStart = startsBlock ? nullptr : m_blockStarts.back();
+        size_t carried = startsBlock ? 0 : static_cast<size_t>(m_nameChunks.back().Data.get() + m_nameChunks.back().Used - carriedStart);
+
+        // Chunks double in size up to MAX_NAME_CHUNK_SIZE, so small trees stay small without large trees needing many chunks
+        NameChunk chunk;
+        chunk.Capacity = std::max(std::min(std::max(m_nameChunkBytes, MIN_NAME_CHUNK_SIZE), MAX_NAME_CHUNK_SIZE), carried + m_record.size());
+        chunk.Data.reset(new char[chunk.Capacity]);
+        m_nameChunkBytes += chunk.Capacity;
+        std::copy(carriedStart, carriedStart + carried, chunk.Data.get());
+        chunk.Used = carried;
+        if (!startsBlock)
+        {
+            m_blockStarts.back() = chunk.Data.get();
+        }
+        m_nameChunks.push_back(std::move(chunk));
+    }
+
+    auto &chunk = m_nameChunks.back();
+    if (startsBlock)
+    {
+        m_blockStarts.push_back(chunk.Data.get() + chunk.Used);
+    }
+    std::copy(m_record.begin(), m_record.end(), chunk.Data.get() + chunk.Used);
+    chunk.Used += m_record.size();
+}
+
+void DirectoryTree::WriteVarint(std::vector<char> &bytes, size_t value)
+{
+    // Seven bits per byte, with the high bit set on every byte but the last. Almost every prefix and suffix length fits in one byte.
+    while (value >= 0x80)
+    {
+        bytes.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    bytes.push_back(static_cast<char>(value));
+}
+
+size_t DirectoryTree::ReadVarint(const char *&cursor)
+{
+    size_t value = 0;
+    int shift = 0;
+    while (true)
+    {
+        auto byte = static_cast<unsigned char>(*cursor++);
+        value |= static_cast<size_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            return value;
+        }
+        shift += 7;
+    }
+}
+
+DirectoryTree::EntryId DirectoryTree::Append(EntryId parent, const std::string &name, EntryType type, bool startsSiblingGroup)
+{
+    EntryId id = static_cast<EntryId>(m_parentAndType.size());
+    if (m_parentAndType.size() >= MAX_ENTRIES)
+    {
+        std::cout << " Error: directory tree capacity exceeded in " << __FILE__ << " at line " << __LINE__ << endl;
+        std::terminate();
+    }
+
+    try
+    {
+        // Each block starts with a complete name, so any entry can be decoded by reading at most BLOCK_SIZE names from its block's start
+        size_t sharedPrefix = 0;
+        bool startsBlock = (id % BLOCK_SIZE == 0);
+        if (!startsBlock)
+        {
+            auto limit = std::min(name.size(), m_lastName.size());
+            while (sharedPrefix < limit && name[sharedPrefix] == m_lastName[sharedPrefix])
+            {
+                sharedPrefix++;
+            }
+        }
+
+        m_record.clear();
+        WriteVarint(m_record, sharedPrefix);
+        WriteVarint(m_record, name.size() - sharedPrefix);
+        m_record.insert(m_record.end(), name.begin() + sharedPrefix, name.end());
+        WriteRecord(startsBlock);
+        m_lastName = name;
+
+        m_parentAndType.push_back((parent << TYPE_BITS) | type);
+        m_startsSiblingGroup.Append(startsSiblingGroup);
+        m_isDirectory.Append(type == ENTRY_DIRECTORY);
+        if (type == ENTRY_DIRECTORY)
+        {
+            m_firstChildOfDirectory.push_back(NO_ENTRY);
+        }
+    }
+    catch (const std::bad_alloc &ex)
+    {
+        std::cout << " Error bad allocation caught in " << __FILE__ << " at line " << __LINE__ << endl;
+        std::cout << " Exception: " << ex.what() << endl;
+        std::terminate();
+    }
+
+    // What the same name would cost as a std::string: the object itself, plus a heap allocation once it no longer fits in the small string buffer
+    m_stringLayoutBytes += sizeof(std::string) + ((name.size() > SSO_CAPACITY) ? name.size() + 1 : 0);
+    return id;
+}
+
+DirectoryTree::EntryId DirectoryTree::AddListing(EntryId directory, const std::vector<std::pair<std::string, EntryType>> &entries)
+{
+    if (entries.empty())
+    {
+        return NO_ENTRY;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    EntryId first = static_cast<EntryId>(m_parentAndType.size());
+    for (size_t ix = 0; ix < entries.size(); ix++)
+    {
+        Append(directory, entries[ix].first, entries[ix].second, ix == 0);
+    }
+
+    if (m_isDirectory.Get(directory))
+    {
+        m_firstChildOfDirectory[m_isDirectory.Rank(directory)] = first;
+    }
+    return first;
+}
+
+size_t DirectoryTree::Size() const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return m_parentAndType.size();
+}
+
+DirectoryTree::EntryId DirectoryTree::Parent(EntryId id) const
+{
+    if (id == Root())
+    {
+        return NO_ENTRY;
+    }
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return m_parentAndType[id] >> TYPE_BITS;
+}
+
+DirectoryTree::EntryType DirectoryTree::Type(EntryId id) const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return static_cast<EntryType>(m_parentAndType[id] & TYPE_MASK);
+}
+
+std::string DirectoryTree::DecodeName(EntryId id) const
+{
+    std::string name;
+    const char *cursor = m_blockStarts[id / BLOCK_SIZE];
+    for (size_t ix = 0; ix <= id % BLOCK_SIZE; ix++)
+    {
+        size_t sharedPrefix = ReadVarint(cursor);
+        size_t suffixLength = ReadVarint(cursor);
+        name.resize(sharedPrefix);
+        name.append(cursor, suffixLength);
+        cursor += suffixLength;
+    }
+    return name;
+}
+
+std::string DirectoryTree::Name(EntryId id) const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return DecodeName(id);
+}
+
+std::string DirectoryTree::FullPath(EntryId id) const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+
+    std::filesystem::path fullPath;
+    std::vector<EntryId> ancestors;
+    for (EntryId current = id; current != Root(); current = m_parentAndType[current] >> TYPE_BITS)
+    {
+        ancestors.push_back(current);
+    }
+
+    fullPath = m_rootPath;
+    for (auto it = ancestors.rbegin(); it != ancestors.rend(); ++it)
+    {
+        fullPath /= DecodeName(*it);
+    }
+    return fullPath.string();
+}
+
+std::pair<DirectoryTree::EntryId, DirectoryTree::EntryId> DirectoryTree::Children(EntryId directory) const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    if (!m_isDirectory.Get(directory))
+    {
+        return { 0, 0 };
+    }
+
+    EntryId first = m_firstChildOfDirectory[m_isDirectory.Rank(directory)];
+    if (first == NO_ENTRY)
+    {
+        return { 0, 0 };
+    }
+
+    // A listing runs until the next listing starts (or the end of the tree)
+    return { first, static_cast<EntryId>(m_startsSiblingGroup.NextSetBit(first + 1)) };
+}
+
+size_t DirectoryTree::MemoryUsage() const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    // Capacities rather than sizes, since that's what's actually allocated
+    return m_parentAndType.capacity() * sizeof(uint32_t)
+        + m_nameChunkBytes
+        + m_nameChunks.capacity() * sizeof(NameChunk)
+        + m_blockStarts.capacity() * sizeof(const char*)
+        + m_isDirectory.MemoryUsage()
+        + m_startsSiblingGroup.MemoryUsage()
+        + m_firstChildOfDirectory.capacity() * sizeof(EntryId);
+}
+
+size_t DirectoryTree::StringLayoutMemoryUsage() const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return m_stringLayoutBytes;
+}
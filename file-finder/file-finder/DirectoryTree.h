@@ -0,0 +1,151 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <shared_mutex>
+#include <utility>
+#include <memory>
+
+namespace fileFinder
+{
+    /// DirectoryTree is a compact, append-only store of every entry found while walking a path, designed to hold tens of millions of entries where
+    /// a std::string per name would not fit in memory. Entries are appended a whole directory listing at a time, so siblings are always contiguous:
+    /// - names are front-coded in blocks of BLOCK_SIZE entries (each name stores only the suffix that differs from the previous name in its block),
+    /// - each entry packs its parent's ID and its entry type into a single 32 bit word,
+    /// - directories find their children through a rank-indexed bit vector rather than a pointer or list per directory.
+    /// Listings sorted by name compress best, since sorted siblings share the longest prefixes.
+    /// When the walk keeps a tree it's the only copy of the names walked: buffers carry ranges of entry IDs (@see FileNames::EntryRanges), the matchers
+    /// decode names with ForEachName, and full paths are only rebuilt (with FullPath) for the entries that need one.
+    /// sample usage:
+    /// DirectoryTree tree(rootPath);
+    /// auto first = tree.AddListing(tree.Root(), entries);
+    /// tree.ForEachName(first, first + entries.size(), [](DirectoryTree::EntryId id, const std::string &name) { ... });
+    /// std::string path = tree.FullPath(first);
+    class DirectoryTree
+    {
+    public:
+        typedef uint32_t EntryId;
+
+        /// Entry types, stored in the low TYPE_BITS bits of each entry's packed parent word
+        enum EntryType : uint32_t
+        {
+            ENTRY_FILE = 0,
+            ENTRY_DIRECTORY = 1,
+            ENTRY_SYMLINK = 2,
+            ENTRY_OTHER = 3
+        };
+
+        static constexpr EntryId NO_ENTRY{ 0xFFFFFFFF };
+
+    private:
+        /// Append-only bit vector with a running count of set bits before each 64 bit word, so rank queries cost one lookup and one popcount.
+        struct RankedBitVector
+        {
+            std::vector<uint64_t> Words;
+            std::vector<uint32_t> RankBeforeWord;
+            size_t Size{ 0 };
+
+            void Append(bool bit);
+            bool Get(size_t index) const;
+            /// Returns the number of set bits before index
+            size_t Rank(size_t index) const;
+            /// Returns the index of the first set bit at or after index, or Size if there is none
+            size_t NextSetBit(size_t index) const;
+            size_t MemoryUsage() const;
+        };
+
+        static constexpr uint32_t TYPE_BITS{ 2 };
+        static constexpr uint32_t TYPE_MASK{ (1u << TYPE_BITS) - 1 };
+        static constexpr size_t MAX_ENTRIES{ size_t(1) << (32 - TYPE_BITS) };
+        static constexpr size_t BLOCK_SIZE{ 16 };
+        static constexpr size_t SSO_CAPACITY{ 15 };
+        static constexpr size_t MIN_NAME_CHUNK_SIZE{ 4 * 1024 };
+        static constexpr size_t MAX_NAME_CHUNK_SIZE{ 256 * 1024 };
+
+        /// Names are written to chunks that are never reallocated, so once a block's address has been read (under the lock) the names in it that had
+        /// already been added can be decoded without the lock, while the walker keeps appending. Every block is stored whole in a single chunk.
+        struct NameChunk
+        {
+            std::unique_ptr<char[]> Data;
+            size_t Capacity{ 0 };
+            size_t Used{ 0 };
+        };
+
+        mutable std::shared_mutex m_mutex;
+        std::string m_rootPath;
+        std::vector<uint32_t> m_parentAndType;
+        std::vector<NameChunk> m_nameChunks;
+        size_t m_nameChunkBytes{ 0 };
+        /// The address of the first name in each block
+        std::vector<const char*> m_blockStarts;
+        std::vector<char> m_record;
+        std::string m_lastName;
+        RankedBitVector m_isDirectory;
+        RankedBitVector m_startsSiblingGroup;
+        std::vector<EntryId> m_firstChildOfDirectory;
+        size_t m_stringLayoutBytes{ 0 };
+
+        /// Appends a single entry, front-coding its name against the previous entry in its block. Caller must hold m_mutex exclusively.
+        EntryId Append(EntryId parent, const std::string &name, EntryType type, bool startsSiblingGroup);
+
+        /// Copies the encoded name in m_record to the current chunk, starting a new chunk (and moving the unfinished block to it, unless this
+        /// name starts a block) if it doesn't fit. Caller must hold m_mutex exclusively.
+        void WriteRecord(bool startsBlock);
+
+        /// Decodes the name of the entry specified. Caller must hold m_mutex.
+        std::string DecodeName(EntryId id) const;
+
+        static void WriteVarint(std::vector<char> &bytes, size_t value);
+        static size_t ReadVarint(const char *&cursor);
+
+    public:
+
+        DirectoryTree() = delete;
+
+        /// Creates a tree containing only the root entry (ID 0), whose name is the path walked.
+        explicit DirectoryTree(const std::string &rootPath);
+
+        /// Copying this object is not part of our use case, so we'll set it up as non-copyable
+        DirectoryTree(const DirectoryTree&) = delete;
+        DirectoryTree& operator=(const DirectoryTree&) = delete;
+
+        /// Returns the ID of the root entry
+        EntryId Root() const { return 0; }
+
+        /// Appends the complete listing of the directory specified, returning the ID given to the first entry (the rest follow consecutively),
+        /// or NO_ENTRY if the listing was empty. Each directory's listing should be added exactly once.
+        EntryId AddListing(EntryId directory, const std::vector<std::pair<std::string, EntryType>> &entries);
+
+        /// Returns the number of entries in the tree, including the root
+        size_t Size() const;
+
+        /// Returns the ID of the parent of the entry specified, or NO_ENTRY for the root
+        EntryId Parent(EntryId id) const;
+
+        /// Returns the type of the entry specified
+        EntryType Type(EntryId id) const;
+
+        /// Returns the name of the entry specified
+        std::string Name(EntryId id) const;
+
+        /// Rebuilds the full path of the entry specified from its ancestors' names
+        std::string FullPath(EntryId id) const;
+
+        /// Returns the range [first, last) of IDs of the children of the directory specified (first == last if it has none or hasn't been listed)
+        std::pair<EntryId, EntryId> Children(EntryId directory) const;
+
+        /// Decodes the names of the entries with IDs in the range [first, last) in ID order, calling visitor(EntryId, const std::string &) for each.
+        /// This is the fast path for matchers, since it decodes each block once rather than once per entry. The tree is only locked while the range's
+        /// block addresses are read, so visitor runs without holding the lock (and may call back into the tree) and never holds up AddListing.
+        template <typename Visitor>
+        void ForEachName(EntryId first, EntryId last, Visitor visitor) const;
+
+        /// Returns the number of bytes allocated for the tree's encoded data
+        size_t MemoryUsage() const;
+
+        /// Returns the number of bytes the same names would use stored as one std::string each (the layout used by @see FileNames)
+        size_t StringLayoutMemoryUsage() const;
+    };
+}
+
+#include "DirectoryTree_p.h"
@@ -0,0 +1,42 @@
+#pragma once
+#include <string>
+#include <mutex>
+
+namespace fileFinder {
+    template <typename Visitor>
+    void DirectoryTree::ForEachName(EntryId first, EntryId last, Visitor visitor) const
+    {
+        if (first >= last)
+        {
+            return;
+        }
+
+        // Blocks are never moved or changed once their names have been added, so we only need the lock to read where they are
+        size_t firstBlock = first / BLOCK_SIZE;
+        std::vector<const char*> blockStarts;
+        {
+            std::shared_lock<std::shared_mutex> lock(m_mutex);
+            blockStarts.assign(m_blockStarts.begin() + firstBlock, m_blockStarts.begin() + (last - 1) / BLOCK_SIZE + 1);
+        }
+
+        // Walk each block forward from its start, rebuilding each name from the shared prefix of the one before it (which resets at each block)
+        std::string name;
+        const char *cursor = nullptr;
+        for (EntryId id = static_cast<EntryId>(firstBlock * BLOCK_SIZE); id < last; id++)
+        {
+            if (id % BLOCK_SIZE == 0)
+            {
+                cursor = blockStarts[id / BLOCK_SIZE - firstBlock];
+            }
+            size_t sharedPrefix = ReadVarint(cursor);
+            size_t suffixLength = ReadVarint(cursor);
+            name.resize(sharedPrefix);
+            name.append(cursor, suffixLength);
+            cursor += suffixLength;
+            if (id >= first)
+            {
+                visitor(id, name);
+            }
+        }
+    }
+}
@@ -0,0 +1,119 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+#include "MappedFile.h"
+#include "WorkerPool.h"
+#include "FileContentScanner.h"
+
+using namespace std;
+using namespace filesystem;
+using namespace fileFinder;
+
+FileContentScanner::FileContentScanner(RangeMatcher matcher, size_t maxMatchLength) :
+    m_matcher(matcher),
+    m_maxMatchLength(maxMatchLength)
+{
+}
+
+bool FileContentScanner::IsBinary(const char *begin, const char *end)
+{
+    // The same heuristic git uses: text files essentially never contain a NUL byte in their first few kilobytes
+    const char *probeEnd = begin + std::min(static_cast<size_t>(end - begin), BINARY_PROBE_SIZE);
+    return std::find(begin, probeEnd, '\0') != probeEnd;
+}
+
+bool FileContentScanner::Matches(const std::string &path) const
+{
+    // file_size fails for directories and anything else that isn't a regular file, which is exactly what we want to skip
+    std::error_code error;
+    auto size = file_size(path, error);
+    if (error || size == 0)
+    {
+        return false;
+    }
+
+    // Mapping a file costs more than just reading it when it's small, so small files are read with a single read into a per-thread buffer
+    if (size <= SMALL_FILE_SIZE)
+    {
+        thread_local std::vector<char> contents(SMALL_FILE_SIZE);
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+        {
+            return false;
+        }
+        file.read(contents.data(), static_cast<std::streamsize>(size));
+        const char *begin = contents.data();
+        const char *end = begin + file.gcount();
+        if (IsBinary(begin, end))
+        {
+            return false;
+        }
+        return m_matcher(begin, end);
+    }
+
+    MappedFile mappedFile(path);
+    if (!mappedFile.IsValid())
+    {
+        return false;
+    }
+
+    const char *begin = mappedFile.Data();
+    const char *end = begin + mappedFile.Size();
+    if (IsBinary(begin, end))
+    {
+        return false;
+    }
+    return ScanRange(begin, end);
+}
+
+bool FileContentScanner::ScanRange(const char *begin, const char *end) const
+{
+    // A file being scanned on a pool thread is already one of many scanned in parallel, and waiting there on chunks queued behind other files
+    // could leave every pool thread waiting, so it's scanned whole
+    size_t length = static_cast<size_t>(end - begin);
+    if (length < PARALLEL_SCAN_SIZE || WorkerPool::OnWorkerThread())
+    {
+        return m_matcher(begin, end);
+    }
+
+    // Each chunk is extended by one less than the longest possible match, so any match that starts in a chunk is wholly contained in it.
+    // Workers pull chunks from a shared counter and all of them stop as soon as one of them finds a match.
+    size_t overlap = (m_maxMatchLength > 0) ? m_maxMatchLength - 1 : 0;
+    size_t chunkCount = (length + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    std::atomic<size_t> nextChunk{ 0 };
+    std::atomic<bool> found{ false };
+
+    auto scanChunks = [&]()
+    {
+        for (size_t chunk = nextChunk++; chunk < chunkCount && !found; chunk = nextChunk++)
+        {
+            const char *chunkBegin = begin + chunk * CHUNK_SIZE;
+            const char *chunkEnd = begin + std::min(length, (chunk + 1) * CHUNK_SIZE + overlap);
+            if (m_matcher(chunkBegin, chunkEnd))
+            {
+                found.exchange(true);
+            }
+        }
+    };
+
+    // The extra workers run on the shared pool, so however many files are being scanned at once there's only ever one thread per core doing it.
+    // This thread scans chunks too, so the scan still completes if every pool thread is busy with another file's chunks.
+    size_t workerCount = std::min<size_t>(chunkCount, std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<std::future<void>> workers;
+    for (size_t ix = 1; ix < workerCount; ix++)
+    {
+        workers.push_back(WorkerPool::Shared().Run(scanChunks));
+    }
+    scanChunks();
+
+    for (auto &worker : workers)
+    {
+        worker.get();
+    }
+    return found;
+}
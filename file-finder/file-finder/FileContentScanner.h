@@ -0,0 +1,43 @@
+#pragma once
+#include <string>
+#include <functional>
+#include <cstddef>
+
+namespace fileFinder
+{
+    /// FileContentScanner answers whether a file's contents match, using the same matchers that are run against file names.
+    /// Small files are read into memory in a single read, larger files are memory mapped, and files large enough to benefit are split into
+    /// overlapping chunks that are scanned in parallel on the shared @see WorkerPool. Files that look binary (contain a NUL byte near their start) are skipped.
+    class FileContentScanner
+    {
+    public:
+        /// Matcher definition, returns true if a match is found in the byte range [begin, end)
+        typedef std::function<bool(const char *begin, const char *end)> RangeMatcher;
+
+    private:
+        static constexpr size_t SMALL_FILE_SIZE{ 64 * 1024 };
+        static constexpr size_t BINARY_PROBE_SIZE{ 8000 };
+        static constexpr size_t PARALLEL_SCAN_SIZE{ 16 * 1024 * 1024 };
+        static constexpr size_t CHUNK_SIZE{ 4 * 1024 * 1024 };
+        RangeMatcher m_matcher;
+        size_t m_maxMatchLength{ 0 };
+
+        /// Returns true if the range looks like binary data rather than text.
+        static bool IsBinary(const char *begin, const char *end);
+
+        /// Runs the matcher over [begin, end), splitting it into overlapping chunks scanned on the shared worker pool if it's large enough (and
+        /// isn't already being scanned on a pool thread).
+        bool ScanRange(const char *begin, const char *end) const;
+
+    public:
+
+        FileContentScanner() = delete;
+
+        /// Accepts the matcher to run over file contents, and the length of the longest match it can make (chunks overlap by one less than this
+        /// so that a match straddling a chunk boundary is still found).
+        FileContentScanner(RangeMatcher matcher, size_t maxMatchLength);
+
+        /// Returns true if the file specified by path is a readable, non-binary file whose contents match.
+        bool Matches(const std::string &path) const;
+    };
+}
@@ -0,0 +1,56 @@
+#include "FileIdentity.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+using namespace std;
+using namespace fileFinder;
+
+#ifdef _WIN32
+
+bool fileFinder::QueryFileIdentity(const std::string &path, FileIdentity &identity)
+{
+    // FILE_FLAG_BACKUP_SEMANTICS is required to open a handle to a directory, and we only ask for attributes so this works on files we can't read
+    HANDLE file = CreateFileA(path.c_str(), FILE_READ_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+        FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    BY_HANDLE_FILE_INFORMATION information;
+    bool succeeded = GetFileInformationByHandle(file, &information) != FALSE;
+    CloseHandle(file);
+    if (!succeeded)
+    {
+        return false;
+    }
+
+    identity.Device = information.dwVolumeSerialNumber;
+    identity.Index = (static_cast<uint64_t>(information.nFileIndexHigh) << 32) | information.nFileIndexLow;
+    identity.LinkCount = information.nNumberOfLinks;
+    return true;
+}
+
+#else
+
+bool fileFinder::QueryFileIdentity(const std::string &path, FileIdentity &identity)
+{
+    struct stat status;
+    if (stat(path.c_str(), &status) != 0)
+    {
+        return false;
+    }
+
+    identity.Device = static_cast<uint64_t>(status.st_dev);
+    identity.Index = static_cast<uint64_t>(status.st_ino);
+    identity.LinkCount = static_cast<uint64_t>(status.st_nlink);
+    return true;
+}
+
+#endif
@@ -0,0 +1,22 @@
+#pragma once
+#include <string>
+#include <cstdint>
+
+namespace fileFinder
+{
+    /// FileIdentity holds what the operating system uses to tell files apart, which std::filesystem doesn't expose.
+    struct FileIdentity
+    {
+        /// The device (st_dev) or, on Windows, the volume serial number the file lives on
+        uint64_t Device{ 0 };
+
+        /// The file's index on its device (st_ino, or the file index on Windows), so a device and index pair is unique to one file
+        uint64_t Index{ 0 };
+
+        /// The number of hard links to the file, a file with more than one may be reached through several paths
+        uint64_t LinkCount{ 1 };
+    };
+
+    /// Reads the identity of the file or directory at path, following symbolic links, returning false if it can't be read.
+    bool QueryFileIdentity(const std::string &path, FileIdentity &identity);
+}
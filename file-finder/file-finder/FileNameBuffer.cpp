@@ -1,20 +1,97 @@
 #include <vector>
+#include <algorithm>
 #include "FileNames.h"
 #include "FileNameBuffer.h"
 #include "ThreadSafeQueue.h"
+#include "AsyncDirectoryWalker.h"
+#include "DirectoryTree.h"
+#include "FileIdentity.h"
+#include "ConcurrentIdentitySet.h"
 
 using namespace std;
+using namespace std::chrono;
 using namespace filesystem;
 using namespace fileFinder;
 
-fileFinder::FileNameBuffer::FileNameBuffer(const std::string &path, BufferReadyCallback bufferReadyCallback /*= nullptr*/):
-        m_it(recursive_directory_iterator(path, directory_options::skip_permission_denied)),
-        m_path(path),
+namespace
+{
+    // Returns the type the entry specified is recorded with in the tree. A symbolic link we descend into is recorded as a directory, since its
+    // listing is added beneath it.
+    DirectoryTree::EntryType TreeEntryType(const AsyncDirectoryWalker::Entry &entry)
+    {
+        if (entry.IsDirectory)
+        {
+            return DirectoryTree::ENTRY_DIRECTORY;
+        }
+        if (entry.LinkType == file_type::symlink)
+        {
+            return DirectoryTree::ENTRY_SYMLINK;
+        }
+        return (entry.LinkType == file_type::regular) ? DirectoryTree::ENTRY_FILE : DirectoryTree::ENTRY_OTHER;
+    }
+}
+
+fileFinder::FileNameBuffer::FileNameBuffer(const std::vector<std::string> &roots, BufferReadyCallback bufferReadyCallback /*= nullptr*/, const WalkOptions &options /*= WalkOptions()*/):
+        m_roots(roots),
+        m_options(options),
         m_bufferReadyCallback(bufferReadyCallback)
 {
+    GroupRootsByDevice();
+    if (m_options.QueueDepth > 0)
+    {
+        m_asyncWalker = std::make_unique<AsyncDirectoryWalker>(m_options);
+        for (auto &device : m_deviceStatistics)
+        {
+            m_asyncWalker->AddDevice(device.Device, m_options.QueueDepth);
+        }
+
+        // A single root is the root of the tree, several roots become the children of an unnamed root so each keeps its full path
+        if (m_options.CompactTree)
+        {
+            m_directoryTree = std::make_unique<DirectoryTree>((m_roots.size() == 1) ? m_roots.front() : "");
+        }
+    }
+    else
+    {
+        if (m_options.FollowSymlinks)
+        {
+            m_visitedDirectories = std::make_unique<ConcurrentIdentitySet>(1);
+        }
+        if (m_options.DedupeHardlinks)
+        {
+            m_seenHardlinks = std::make_unique<ConcurrentIdentitySet>(1);
+        }
+    }
     InitializeBuffers();
 }
 
+void fileFinder::FileNameBuffer::GroupRootsByDevice()
+{
+    for (auto &root : m_roots)
+    {
+        FileIdentity identity;
+        QueryFileIdentity(root, identity);
+
+        auto device = std::find_if(m_deviceStatistics.begin(), m_deviceStatistics.end(),
+            [&identity](const DeviceStatistics &statistics)
+            {
+                return statistics.Device == identity.Device;
+            }
+        );
+        if (device == m_deviceStatistics.end())
+        {
+            m_deviceStatistics.emplace_back();
+            m_deviceStatistics.back().Device = identity.Device;
+            device = m_deviceStatistics.end() - 1;
+        }
+
+        device->Roots.push_back(root);
+        m_rootDevices.push_back(static_cast<size_t>(device - m_deviceStatistics.begin()));
+    }
+}
+
+fileFinder::FileNameBuffer::~FileNameBuffer() = default;
+
 void fileFinder::FileNameBuffer::InitializeBuffers()
 {
     for (int ix = 0; ix < INITIAL_BUFFER_COUT; ix++)
@@ -28,58 +105,342 @@ void fileFinder::FileNameBuffer::InitializeBuffers()
 
 void fileFinder::FileNameBuffer::PopulateBuffers()
 {
-    auto currentBuffer = m_availableBuffers->Dequeue();
-    while (m_it != recursive_directory_iterator() && !m_terminateEarly)
+    m_walkStart = steady_clock::now();
+    m_lastHandOff = m_walkStart;
+    // Buffers are only taken once there's a name to put in them, so the walk can never end holding an empty buffer that's never returned
+    std::shared_ptr<FileNames> currentBuffer;
+
+    if (m_asyncWalker)
     {
-        auto path = m_it->path().string();
-        auto fileName = m_it->path().filename().string();
+        PopulateBuffersAsynchronously(currentBuffer);
+    }
+    else
+    {
+        PopulateBuffersSynchronously(currentBuffer);
+    }
+    
+    // After we've finished recursively iterating through all the files in the path specified, we want to make sure we process any files remaining
+    if (currentBuffer != nullptr && currentBuffer->Size() > 0)
+    {
+        RecordBatch(*currentBuffer);
+        m_bufferReadyCallback(currentBuffer);
+    }
 
-        // Populate the current buffer until we've got enough file names to pass it back to the parent object so that it can be
-        // processed, and then handle dequeuing our next buffer
-        try 
-        {
-            currentBuffer->Buffer->push_back(fileName);
-        }
-        catch (const std::bad_alloc &ex)
+    m_walkDuration = duration_cast<milliseconds>(steady_clock::now() - m_walkStart);
+    
+    // Set value to indicate we've iterated through all of the potential file names in the path, this will be used in FileNameBuffer::AllFileNamesHaveBeenProcessed()
+    // to track if all of the file names we sent were processed successfully.
+    m_finishedPopulating.exchange(true);
+}
+
+void fileFinder::FileNameBuffer::AddFileName(std::shared_ptr<FileNames> &currentBuffer, const std::string &fileName, const std::string &path)
+{
+    // Populate the current buffer until we've got enough file names to pass it back to the parent object so that it can be
+    // processed, and then handle dequeuing our next buffer
+    if (currentBuffer == nullptr)
+    {
+        currentBuffer = GetNextAvailableBuffer();
+    }
+
+    try 
+    {
+        currentBuffer->Buffer->push_back(fileName);
+        if (m_options.CollectPaths)
         {
-            std::cout << " Error bad allocation caught in " << __FILE__ << " at line " << __LINE__ << endl;
-            std::cout << " Exception: " << ex.what() << endl;
-            std::terminate();
+            currentBuffer->Paths->push_back(path);
         }
+    }
+    catch (const std::bad_alloc &ex)
+    {
+        std::cout << " Error bad allocation caught in " << __FILE__ << " at line " << __LINE__ << endl;
+        std::cout << " Exception: " << ex.what() << endl;
+        std::terminate();
+    }
+    NameAdded(currentBuffer, fileName.size() + path.size());
+}
 
-        if (currentBuffer->Buffer->size() >= FileNames::MAX_BUFFER_SIZE)
+void fileFinder::FileNameBuffer::AddTreeEntry(std::shared_ptr<FileNames> &currentBuffer, DirectoryTree::EntryId id, size_t nameLength)
+{
+    if (currentBuffer == nullptr)
+    {
+        currentBuffer = GetNextAvailableBuffer();
+    }
+
+    // Siblings have consecutive IDs, so a whole directory listing usually becomes a single range
+    try
+    {
+        auto &ranges = *currentBuffer->EntryRanges;
+        if (!ranges.empty() && ranges.back().second == id)
         {
-            m_bufferReadyCallback(currentBuffer);
-            currentBuffer = GetNextAvailableBuffer();
+            ranges.back().second++;
         }
-        
-        try
+        else
         {
-            ++m_it;
+            ranges.emplace_back(id, id + 1);
         }
-        catch (filesystem_error& err)
+    }
+    catch (const std::bad_alloc &ex)
+    {
+        std::cout << " Error bad allocation caught in " << __FILE__ << " at line " << __LINE__ << endl;
+        std::cout << " Exception: " << ex.what() << endl;
+        std::terminate();
+    }
+    currentBuffer->EntryCount++;
+    currentBuffer->Tree = m_directoryTree.get();
+    NameAdded(currentBuffer, nameLength);
+}
+
+void fileFinder::FileNameBuffer::NameAdded(std::shared_ptr<FileNames> &currentBuffer, size_t bytes)
+{
+    m_totalFileNames++;
+    m_currentBatchBytes += bytes;
+
+    if (currentBuffer->Size() >= m_batchSizer.Limit())
+    {
+        HandOffBuffer(currentBuffer);
+    }
+    else if (m_flushingEarly)
+    {
+        FlushEarlyIfDue(currentBuffer);
+    }
+}
+
+void fileFinder::FileNameBuffer::FlushEarlyIfDue(std::shared_ptr<FileNames> &currentBuffer)
+{
+    auto now = steady_clock::now();
+    if (now - m_walkStart >= EARLY_FLUSH_WINDOW)
+    {
+        m_flushingEarly = false;
+    }
+    else if (now - m_lastHandOff >= EARLY_FLUSH_INTERVAL && currentBuffer != nullptr && currentBuffer->Size() > 0)
+    {
+        HandOffBuffer(currentBuffer);
+    }
+}
+
+void fileFinder::FileNameBuffer::RecordBatch(const FileNames &buffer)
+{
+    // Every buffer that isn't available (apart from the one we're filling) is still waiting to be searched by at least one haystack
+    auto available = static_cast<int>(m_availableBuffers->Size());
+    size_t buffersWaiting = static_cast<size_t>(std::max(0, m_totalBuffersCreated - available - 1));
+    m_batchSizer.Record(buffer.Size(), m_currentBatchBytes, buffersWaiting);
+    m_currentBatchBytes = 0;
+}
+
+void fileFinder::FileNameBuffer::HandOffBuffer(std::shared_ptr<FileNames> &currentBuffer)
+{
+    RecordBatch(*currentBuffer);
+    m_bufferReadyCallback(currentBuffer);
+    currentBuffer.reset();
+    if (m_flushingEarly)
+    {
+        m_lastHandOff = steady_clock::now();
+    }
+}
+
+void fileFinder::FileNameBuffer::PopulateBuffersSynchronously(std::shared_ptr<FileNames> &currentBuffer)
+{
+    auto iteratorOptions = directory_options::skip_permission_denied;
+    if (m_options.FollowSymlinks)
+    {
+        iteratorOptions |= directory_options::follow_directory_symlink;
+    }
+
+    for (size_t rootIndex = 0; rootIndex < m_roots.size() && !m_terminateEarly; rootIndex++)
+    {
+        auto &root = m_roots[rootIndex];
+        auto &device = m_deviceStatistics[m_rootDevices[rootIndex]];
+        auto rootStart = steady_clock::now();
+
+        // A root that's inside one we've already walked (or is reached through a link from one) would only be walked again
+        FileIdentity identity;
+        if (m_visitedDirectories && QueryFileIdentity(root, identity) && !m_visitedDirectories->Insert(identity))
         {
-            // Since our project has a simplifying assumption that we have access to all files and directories, we'll go ahead and end the loop if we run into an access error.
-            std::cout << ">>> Error: " << err.what() << " when searching path " << m_path << std::endl;
+            m_revisitedDirectories++;
             continue;
         }
 
+        recursive_directory_iterator it(root, iteratorOptions);
+        device.Directories++;
+
+        while (it != recursive_directory_iterator() && !m_terminateEarly)
+        {
+            std::error_code statError;
+            auto type = m_options.FollowSymlinks ? it->status(statError).type() : it->symlink_status(statError).type();
+
+            if (type == file_type::directory)
+            {
+                device.Directories++;
+
+                // Don't descend into directories that are mounted from another device if we've been asked to stay on this one, or that we've already
+                // entered through another path (which would loop forever if a link leads back up the tree)
+                if ((m_options.OneFileSystem || m_visitedDirectories) && QueryFileIdentity(it->path().string(), identity))
+                {
+                    if (m_options.OneFileSystem && identity.Device != device.Device)
+                    {
+                        it.disable_recursion_pending();
+                    }
+                    else if (m_visitedDirectories && !m_visitedDirectories->Insert(identity))
+                    {
+                        m_revisitedDirectories++;
+                        it.disable_recursion_pending();
+                    }
+                }
+            }
+
+            bool duplicateLink = false;
+            if (m_seenHardlinks && type == file_type::regular && QueryFileIdentity(it->path().string(), identity) && identity.LinkCount > 1)
+            {
+                duplicateLink = !m_seenHardlinks->Insert(identity);
+            }
+
+            if (duplicateLink)
+            {
+                m_duplicateHardlinks++;
+            }
+            else
+            {
+                AddFileName(currentBuffer, it->path().filename().string(), m_options.CollectPaths ? it->path().string() : "");
+                device.FileNames++;
+            }
+            
+            try
+            {
+                ++it;
+            }
+            catch (filesystem_error& err)
+            {
+                // Since our project has a simplifying assumption that we have access to all files and directories, we'll go ahead and end the loop if we run into an access error.
+                std::cout << ">>> Error: " << err.what() << " when searching path " << root << std::endl;
+                continue;
+            }
+
+        }
+        device.Duration += duration_cast<milliseconds>(steady_clock::now() - rootStart);
     }
-    
-    // After we've finished recursively iterating through all the files in the path specified, we want to make sure we process any files remaining
-    if (currentBuffer->Buffer->size() > 0)
+}
+
+void fileFinder::FileNameBuffer::PopulateBuffersAsynchronously(std::shared_ptr<FileNames> &currentBuffer)
+{
+    // This thread only ever touches the buffers, all of the blocking directory reads and stats happen on the walker's I/O threads, and
+    // every subdirectory we're handed back goes straight into the submission queue so the walker always has as much work in flight as it can.
+    // When we're building a tree, each directory's tag is its ID in the tree so its listing can be attached to it when it completes.
+    m_asyncWalker->Start();
+
+    std::vector<std::pair<std::string, DirectoryTree::EntryType>> listing;
+    DirectoryTree::EntryId firstRoot = 0;
+    if (m_directoryTree && m_roots.size() > 1)
     {
-        m_bufferReadyCallback(currentBuffer);
+        for (auto &root : m_roots)
+        {
+            listing.emplace_back(root, DirectoryTree::ENTRY_DIRECTORY);
+        }
+        firstRoot = m_directoryTree->AddListing(m_directoryTree->Root(), listing);
     }
-    
-    // Set value to indicate we've iterated through all of the potential file names in the path, this will be used in FileNameBuffer::AllFileNamesHaveBeenProcessed()
-    // to track if all of the file names we sent were processed successfully.
-    m_finishedPopulating.exchange(true);
+    for (size_t rootIndex = 0; rootIndex < m_roots.size(); rootIndex++)
+    {
+        m_asyncWalker->Submit(m_roots[rootIndex], firstRoot + rootIndex, m_rootDevices[rootIndex]);
+    }
+
+    AsyncDirectoryWalker::Completion completion;
+    while (!m_terminateEarly && m_asyncWalker->OutstandingReads() > 0)
+    {
+        if (m_flushingEarly)
+        {
+            // Early in the walk a slow directory read mustn't hold back the names we already have, so only wait until the next early flush is due
+            auto now = steady_clock::now();
+            auto flushDue = (currentBuffer != nullptr && currentBuffer->Size() > 0) ? m_lastHandOff + EARLY_FLUSH_INTERVAL : m_walkStart + EARLY_FLUSH_WINDOW;
+            auto status = m_asyncWalker->NextCompletion(completion, (flushDue > now) ? flushDue - now : steady_clock::duration::zero());
+            if (status == AsyncDirectoryWalker::WaitStatus::Stopped)
+            {
+                break;
+            }
+            if (status == AsyncDirectoryWalker::WaitStatus::TimedOut)
+            {
+                FlushEarlyIfDue(currentBuffer);
+                continue;
+            }
+        }
+        else if (!m_asyncWalker->NextCompletion(completion))
+        {
+            break;
+        }
+
+        auto &device = m_deviceStatistics[completion.DeviceIndex];
+        device.Duration = duration_cast<milliseconds>(steady_clock::now() - m_walkStart);
+        if (completion.AlreadyVisited)
+        {
+            m_revisitedDirectories++;
+            continue;
+        }
+
+        // Duplicate hard links are dropped before anything else sees the listing, so tree IDs and buffers only ever cover the entries we keep
+        auto duplicates = std::remove_if(completion.Entries.begin(), completion.Entries.end(),
+            [](const AsyncDirectoryWalker::Entry &entry)
+            {
+                return entry.IsDuplicateLink;
+            }
+        );
+        m_duplicateHardlinks += static_cast<int64_t>(completion.Entries.end() - duplicates);
+        completion.Entries.erase(duplicates, completion.Entries.end());
+
+        device.Directories++;
+        device.FileNames += static_cast<int64_t>(completion.Entries.size());
+
+        if (!completion.Error.empty())
+        {
+            std::cout << ">>> Error: " << completion.Error << " when searching path " << completion.Directory << std::endl;
+        }
+
+        DirectoryTree::EntryId firstEntry = 0;
+        if (m_directoryTree)
+        {
+            // Sorted siblings share longer prefixes, which is what the tree's front coding relies on
+            std::sort(completion.Entries.begin(), completion.Entries.end(),
+                [](const AsyncDirectoryWalker::Entry &left, const AsyncDirectoryWalker::Entry &right)
+                {
+                    return left.Name < right.Name;
+                }
+            );
+
+            listing.clear();
+            for (auto &entry : completion.Entries)
+            {
+                listing.emplace_back(entry.Name, TreeEntryType(entry));
+            }
+            firstEntry = m_directoryTree->AddListing(static_cast<DirectoryTree::EntryId>(completion.Tag), listing);
+        }
+
+        for (size_t ix = 0; ix < completion.Entries.size(); ix++)
+        {
+            auto &entry = completion.Entries[ix];
+            if (entry.IsDirectory && !entry.OnOtherDevice)
+            {
+                m_asyncWalker->SubmitSubdirectory(completion, entry.Path, firstEntry + ix);
+            }
+
+            // With a tree the buffers only carry entry IDs, the names and paths stay in the tree
+            if (m_directoryTree)
+            {
+                AddTreeEntry(currentBuffer, static_cast<DirectoryTree::EntryId>(firstEntry + ix), entry.Name.size());
+            }
+            else
+            {
+                AddFileName(currentBuffer, entry.Name, m_options.CollectPaths ? entry.Path : "");
+            }
+        }
+    }
+
+    m_asyncWalker->Stop();
 }
 
 void fileFinder::FileNameBuffer::Stop()
 {
     m_terminateEarly.exchange(true);
+    if (m_asyncWalker)
+    {
+        m_asyncWalker->Stop();
+    }
 }
 
 std::shared_ptr<FileNames> fileFinder::FileNameBuffer::GetNextAvailableBuffer()
@@ -88,6 +449,9 @@ std::shared_ptr<FileNames> fileFinder::FileNameBuffer::GetNextAvailableBuffer()
     {
         std::shared_ptr<FileNames> buffer = m_availableBuffers->Dequeue();
         buffer->Buffer->clear();
+        buffer->Paths->clear();
+        buffer->EntryRanges->clear();
+        buffer->EntryCount = 0;
         buffer->ProcessedCount.exchange(0);
         return buffer;
     }
@@ -117,3 +481,56 @@ bool fileFinder::FileNameBuffer::AllFileNamesHaveBeenProcessed()
     return false;
 }
 
+int64_t fileFinder::FileNameBuffer::TotalFileNames() const
+{
+    return m_totalFileNames;
+}
+
+int64_t fileFinder::FileNameBuffer::RevisitedDirectories() const
+{
+    return m_revisitedDirectories;
+}
+
+int64_t fileFinder::FileNameBuffer::DuplicateHardlinks() const
+{
+    return m_duplicateHardlinks;
+}
+
+const ConcurrentIdentitySet *fileFinder::FileNameBuffer::VisitedDirectories() const
+{
+    return m_asyncWalker ? m_asyncWalker->VisitedDirectories() : m_visitedDirectories.get();
+}
+
+const ConcurrentIdentitySet *fileFinder::FileNameBuffer::SeenHardlinks() const
+{
+    return m_asyncWalker ? m_asyncWalker->SeenHardlinks() : m_seenHardlinks.get();
+}
+
+std::chrono::milliseconds fileFinder::FileNameBuffer::WalkDuration() const
+{
+    return m_walkDuration;
+}
+
+const std::vector<FileNameBuffer::DeviceStatistics> &fileFinder::FileNameBuffer::DeviceStats() const
+{
+    return m_deviceStatistics;
+}
+
+const BatchSizer::Statistics &fileFinder::FileNameBuffer::BatchStats() const
+{
+    return m_batchSizer.Stats();
+}
+
+const DirectoryTree *fileFinder::FileNameBuffer::Tree() const
+{
+    return m_directoryTree.get();
+}
+
+std::string fileFinder::FileNameBuffer::BackendName() const
+{
+    if (m_asyncWalker)
+    {
+        return "asynchronous (queue depth " + std::to_string(m_options.QueueDepth) + " per device)";
+    }
+    return "synchronous";
+}
@@ -4,43 +4,117 @@
 #include <condition_variable>
 #include <string>
 #include <filesystem>
+#include <chrono>
+#include <vector>
+#include <cstdint>
+#include "WalkOptions.h"
+#include "BatchSizer.h"
+#include "DirectoryTree.h"
 
 namespace fileFinder
 {
     template <typename T>
     class ThreadSafeQueue;
     struct FileNames;
+    class AsyncDirectoryWalker;
+    class ConcurrentIdentitySet;
 
     /// FileNameBuffer wraps std::filesystem::recursive_directory_iterator to provide a list of read-only buffers (in a callback) as the specified path is searched for file names, which
     /// can the be passed to one or more consuming threads for searching. Buffers should re-enqueued once they have been searched in order to allow a pool of buffers to be
     /// reused (and to reduce memory fragmentation).
+    /// Several root paths may be walked at once. Roots are grouped by the device they live on, and statistics are kept for each device.
+    /// If @see WalkOptions::QueueDepth is non-zero the path is enumerated by an @see AsyncDirectoryWalker instead, which keeps many directory reads in flight at once.
     class FileNameBuffer
     {
     public:
         /// Callback definition triggered when a filesystem buffer is ready for processing by one or more consumers
         typedef std::function<void(std::shared_ptr<FileNames>)> BufferReadyCallback;
 
+        /// Throughput figures for the roots on a single device, available once PopulateBuffers has finished
+        struct DeviceStatistics
+        {
+            uint64_t Device{ 0 };
+            std::vector<std::string> Roots;
+            int64_t FileNames{ 0 };
+            int64_t Directories{ 0 };
+            /// Time spent walking this device's roots, devices are walked concurrently by the asynchronous walker so this is the time until its last directory was read
+            std::chrono::milliseconds Duration{ 0 };
+        };
+
     private:
         const int INITIAL_BUFFER_COUT{ 64 };
-        std::string m_path;
+        /// For the first second of a walk, buffers are handed off at least this often even if they aren't full, so the first matches show up
+        /// within milliseconds rather than once a whole buffer's worth of file names has been found
+        static constexpr std::chrono::milliseconds EARLY_FLUSH_WINDOW{ 1000 };
+        static constexpr std::chrono::milliseconds EARLY_FLUSH_INTERVAL{ 10 };
+        std::vector<std::string> m_roots;
+        std::vector<size_t> m_rootDevices;
+        std::vector<DeviceStatistics> m_deviceStatistics;
+        WalkOptions m_options;
         std::atomic<bool> m_finishedPopulating{ false };
         std::unique_ptr<ThreadSafeQueue<std::shared_ptr<FileNames>>> m_availableBuffers{std::make_unique<ThreadSafeQueue<std::shared_ptr<FileNames>>>()};
         std::atomic<int> m_totalBuffersCreated{ 0 };
-        std::filesystem::recursive_directory_iterator m_it;
         BufferReadyCallback m_bufferReadyCallback;
+        std::unique_ptr<AsyncDirectoryWalker> m_asyncWalker;
+        std::unique_ptr<DirectoryTree> m_directoryTree;
+        // Only used by the synchronous walker, the asynchronous walker keeps its own sets shared by its I/O threads
+        std::unique_ptr<ConcurrentIdentitySet> m_visitedDirectories;
+        std::unique_ptr<ConcurrentIdentitySet> m_seenHardlinks;
+        int64_t m_revisitedDirectories{ 0 };
+        int64_t m_duplicateHardlinks{ 0 };
         std::atomic<bool> m_terminateEarly{ false };
+        std::atomic<int64_t> m_totalFileNames{ 0 };
+        std::chrono::milliseconds m_walkDuration{ 0 };
+        std::chrono::steady_clock::time_point m_walkStart;
+        std::chrono::steady_clock::time_point m_lastHandOff;
+        bool m_flushingEarly{ true };
+        BatchSizer m_batchSizer;
+        size_t m_currentBatchBytes{ 0 };
         
         /// Returns the next available buffer for populating, if there are no buffers left to populate then a new buffer will be
         /// allocated and the total number of buffers created will be increased by one.
         std::shared_ptr<FileNames> GetNextAvailableBuffer();
 
+        /// Records the size of the batch held in the buffer specified with @see BatchSizer, ready for it to be handed off.
+        void RecordBatch(const FileNames &buffer);
+
+        /// Passes the current buffer to BufferReadyCallback and releases it, the next available buffer is only taken once another name arrives.
+        void HandOffBuffer(std::shared_ptr<FileNames> &currentBuffer);
+
+        /// Adds a file name to the current buffer (taking the next available buffer if there isn't one), passing the buffer to BufferReadyCallback once it holds
+        /// as many names as @see BatchSizer allows (or, early in the walk, once EARLY_FLUSH_INTERVAL has passed since the last buffer was handed off).
+        void AddFileName(std::shared_ptr<FileNames> &currentBuffer, const std::string &fileName, const std::string &path);
+
+        /// Adds the tree entry specified to the current buffer's ranges of entry IDs, in place of @see FileNameBuffer::AddFileName when a tree is kept.
+        void AddTreeEntry(std::shared_ptr<FileNames> &currentBuffer, DirectoryTree::EntryId id, size_t nameLength);
+
+        /// Counts a name just added to the current buffer, handing the buffer off if it's full or an early flush is due.
+        void NameAdded(std::shared_ptr<FileNames> &currentBuffer, size_t bytes);
+
+        /// While within EARLY_FLUSH_WINDOW of the start of the walk, hands off the current buffer if it holds any names and EARLY_FLUSH_INTERVAL has
+        /// passed since the last buffer was handed off. Called as names are added, and by the asynchronous walker whenever it waits that long for a read.
+        void FlushEarlyIfDue(std::shared_ptr<FileNames> &currentBuffer);
+
+        /// Groups the roots by the device they live on, creating the statistics for each device.
+        void GroupRootsByDevice();
+
+        /// Populates buffers one directory entry at a time using recursive_directory_iterator (used when QueueDepth is zero), one root after another.
+        void PopulateBuffersSynchronously(std::shared_ptr<FileNames> &currentBuffer);
+
+        /// Populates buffers from the completions of an @see AsyncDirectoryWalker, submitting each subdirectory found as a new read.
+        /// Every device gets its own share of I/O threads, so each device has up to QueueDepth reads in flight.
+        void PopulateBuffersAsynchronously(std::shared_ptr<FileNames> &currentBuffer);
+
     public:
 
         FileNameBuffer() = delete;
 
-        /// Accepts a path to generate buffers from by iterating the path recursively and pulling out all of the file names contained in the directory.
+        /// Accepts one or more root paths to generate buffers from by iterating each path recursively and pulling out all of the file names contained in it.
         /// Allows consuming object to specify code that will be triggered in a callback whenever a new buffer of file names is ready for processing.
-        explicit FileNameBuffer(const std::string &path, BufferReadyCallback bufferReadyCallback = nullptr);
+        /// The options specified select the enumeration backend @see WalkOptions.
+        FileNameBuffer(const std::vector<std::string> &roots, BufferReadyCallback bufferReadyCallback = nullptr, const WalkOptions &options = WalkOptions());
+
+        ~FileNameBuffer();
 
         /// Copying this object is not part of our use case, so we'll set it up as non-copyable
         FileNameBuffer& operator=(const FileNameBuffer&) = delete;
@@ -64,5 +138,35 @@ namespace fileFinder
         /// files in the path.
         bool AllFileNamesHaveBeenProcessed();
 
+        /// Returns the number of file names that have been placed into buffers so far.
+        int64_t TotalFileNames() const;
+
+        /// Returns the number of directories reached again through another path and so not entered, @see WalkOptions::FollowSymlinks
+        int64_t RevisitedDirectories() const;
+
+        /// Returns the number of duplicate hard links left out of the buffers, @see WalkOptions::DedupeHardlinks
+        int64_t DuplicateHardlinks() const;
+
+        /// Returns the set of directories entered, or nullptr if symbolic links aren't followed
+        const ConcurrentIdentitySet *VisitedDirectories() const;
+
+        /// Returns the set of files with more than one hard link seen, or nullptr if duplicate hard links aren't suppressed
+        const ConcurrentIdentitySet *SeenHardlinks() const;
+
+        /// Returns how long PopulateBuffers took to enumerate the path once it has finished.
+        std::chrono::milliseconds WalkDuration() const;
+
+        /// Returns the throughput figures for each device walked, should only be called once PopulateBuffers has finished.
+        const std::vector<DeviceStatistics> &DeviceStats() const;
+
+        /// Returns how the number of names in each buffer was adapted over the walk, should only be called once PopulateBuffers has finished.
+        const BatchSizer::Statistics &BatchStats() const;
+
+        /// Returns the tree of every entry walked if @see WalkOptions::CompactTree was set, otherwise nullptr.
+        const DirectoryTree *Tree() const;
+
+        /// Returns a short description of the enumeration backend in use, for display purposes.
+        std::string BackendName() const;
+
     };
 }
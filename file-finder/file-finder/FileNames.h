@@ -4,17 +4,32 @@
 #include <vector>
 #include <string>
 #include <iostream>
+#include <utility>
+#include "DirectoryTree.h"
 
 namespace fileFinder
 {
     /// FileNames is a struct produced by @see FileNameBuffer, and consumed by @see FilesystemHaystack via the @see ResultMonitor class.
     /// It is designed to provide a buffer containing a list of file names to process, as well as an atomic counter to track how many
-    /// times it has been processed by one ore more FilesystemHaystack objects using a different thread.
+    /// times it has been processed by one ore more FilesystemHaystack objects using a different thread. The number of names in each buffer is
+    /// chosen as the walk goes by @see BatchSizer.
     struct FileNames
     {
-        static const int MAX_BUFFER_SIZE{ 1024 };
         std::atomic<int> ID{ 0 };
         std::shared_ptr<std::vector<std::string>> Buffer{ std::make_shared<std::vector<std::string>>() };
+        /// Full paths for each entry in Buffer, only populated when @see WalkOptions::CollectPaths is set (e.g. for content searches)
+        std::shared_ptr<std::vector<std::string>> Paths{ std::make_shared<std::vector<std::string>>() };
+        /// When the walk keeps a @see DirectoryTree (@see WalkOptions::CompactTree) the names aren't copied into Buffer or Paths at all, instead the
+        /// buffer holds the ranges [first, last) of IDs of its entries in Tree, and EntryCount is the number of entries those ranges cover
+        std::shared_ptr<std::vector<std::pair<DirectoryTree::EntryId, DirectoryTree::EntryId>>> EntryRanges{ std::make_shared<std::vector<std::pair<DirectoryTree::EntryId, DirectoryTree::EntryId>>>() };
+        size_t EntryCount{ 0 };
+        const DirectoryTree *Tree{ nullptr };
         std::atomic<size_t> ProcessedCount{ 0 };
+
+        /// Returns the number of file names in the buffer, however they're stored
+        size_t Size() const
+        {
+            return Buffer->size() + EntryCount;
+        }
     };
 }
@@ -1,74 +1,62 @@
-#include <iostream>
 #include <vector>
 #include <string>
-#include <filesystem>
-#include <cassert>
 #include "FileNames.h"
 #include "ThreadSafeQueue.h"
 #include "FilesystemHaystack.h"
+#include "Matchers.h"
+#include "FuzzyMatcher.h"
+#include "ResultSinks.h"
 
 using namespace std;
-using namespace filesystem;
 using namespace fileFinder;
 
-FilesystemHaystack::FilesystemHaystack(const std::string &path, const std::string &needle, ResultsCallback resultsCallback /*= nullptr*/, FinishedBufferCallback finishedCallback /*= nullptr*/) :
-    m_path(path), 
-    m_needle(needle),
-    m_resultsCallback(resultsCallback),
-    m_finishedCallback(finishedCallback)
+namespace
 {
-    assert(m_resultsCallback != nullptr);
-    assert(m_finishedCallback != nullptr);
-}
+    template <typename Matcher, typename Sink>
+    std::unique_ptr<Haystack> MakeHaystack(Matcher matcher, Sink sink, Haystack::FinishedBufferCallback finishedCallback)
+    {
+        return std::make_unique<FilesystemHaystack<Matcher, Sink>>(std::move(matcher), std::move(sink), finishedCallback);
+    }
 
-void FilesystemHaystack::FindNeedles()
-{
-    // Loop until m_terminate is set to true in m_resultsCallback.
-    while(!m_terminateSearch)
+    /// Exact matchers can search either file names or, wrapped in a ContentMatcher, file contents
+    template <typename Matcher, typename Sink>
+    std::unique_ptr<Haystack> MakeExactHaystack(Matcher matcher, Sink sink, const SearchOptions &options, Haystack::FinishedBufferCallback finishedCallback)
     {
-        if (m_buffersToProcess->Size() > 0)
+        if (options.Content)
         {
-            auto readOnlyBuffer = m_buffersToProcess->Dequeue();
-            for (auto name : *readOnlyBuffer->Buffer)
-            {
-                try 
-                {
-                    // Search the fileName string using boyer_moore algorithm for pattern matching
-                    auto searchIt = std::search(name.begin(), name.end(), std::boyer_moore_searcher(m_needle.begin(), m_needle.end()));
-                    
-                    // If a match for the needle is found in our fileName then trigger a callback to add the fileName to our container
-                    // otherwise pass an empty string to the callback so that we can still see if the user wishes to terminate
-                    if (searchIt != name.end())
-                    {
-                        m_resultsCallback(name);
-                    }
-                }
-                catch (const std::bad_alloc &ex)
-                {
-                    std::cout << " Error bad allocation caught in " << __FILE__ << " at line " << __LINE__ << endl;
-                    std::cout << " Exception: " << ex.what() << endl;
-                    std::terminate();
-                }
-
-                if (m_terminateSearch)
-                {
-                    break;
-                }
-            }
-            m_finishedCallback(readOnlyBuffer);
+            return MakeHaystack(ContentMatcher<Matcher>(std::move(matcher)), std::move(sink), finishedCallback);
         }
-
-        // TODO: We could probably use a wait condition here...
-        std::this_thread::yield();
+        return MakeHaystack(std::move(matcher), std::move(sink), finishedCallback);
     }
-}
 
-void fileFinder::FilesystemHaystack::EnqueueBufferToProcess(std::shared_ptr<FileNames> buffer)
-{
-    m_buffersToProcess->Enqueue(buffer);
+    /// Exact matches are either streamed to the results as they're found or kept in sorted runs until the search is complete
+    template <typename Matcher>
+    std::unique_ptr<Haystack> MakeExactHaystack(Matcher matcher, const SearchOptions &options, ResultSpool *results, Haystack::FinishedBufferCallback finishedCallback)
+    {
+        if (options.Sorted)
+        {
+            return MakeExactHaystack(std::move(matcher), SortedSink(), options, finishedCallback);
+        }
+        return MakeExactHaystack(std::move(matcher), QueueSink(results), options, finishedCallback);
+    }
 }
 
-void fileFinder::FilesystemHaystack::Stop()
+std::unique_ptr<Haystack> Haystack::Create(const std::vector<std::string> &needles, const SearchOptions &options, ResultSpool *results,
+    FinishedBufferCallback finishedCallback)
 {
-    m_terminateSearch.exchange(true);
+    // This is the only place the options are looked at, every combination below is its own compile time specialization of FilesystemHaystack
+    if (options.MaxEditDistance >= 0)
+    {
+        return MakeHaystack(FuzzyMatcher(needles.front(), options.MaxEditDistance, options.IgnoreCase),
+            RankedSink(options.TopK > 0 ? static_cast<size_t>(options.TopK) : 0), finishedCallback);
+    }
+    else if (needles.size() > 1)
+    {
+        return MakeExactHaystack(MultiPatternMatcher(needles, options.IgnoreCase), options, results, finishedCallback);
+    }
+    else if (options.IgnoreCase)
+    {
+        return MakeExactHaystack(SubstringMatcher<true>(needles.front()), options, results, finishedCallback);
+    }
+    return MakeExactHaystack(SubstringMatcher<false>(needles.front()), options, results, finishedCallback);
 }
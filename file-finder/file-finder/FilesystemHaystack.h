@@ -1,50 +1,62 @@
 #pragma once
 #include <vector>
 #include <string>
-#include <filesystem>
-#include <functional>
 #include <atomic>
 #include <thread>
+#include <memory>
+#include "Haystack.h"
+#include "DirectoryTree.h"
 
 namespace fileFinder
 {
-    class SynchronizedDirectoryIterator;
-    struct FileNames;
-
     /// Allows consumers to specify a, "needle" that can be found in file names in the path specified.
-    /// Note: Object is designed to pass matching, "needles" back to consumer via ResultCallback and FinishedCallback to allow for multi-threading if desired.
-    class FilesystemHaystack
+    /// FilesystemHaystack is specialized at compile time over two policies, so the loop over each buffer's file names has no indirect calls in it
+    /// and the compiler is free to inline the matcher into it:
+    /// - Matcher provides `bool Matches(const std::string &entry, int &score) const` and `static constexpr bool SEARCHES_PATHS` (true if it
+    ///   should be given each entry's full path rather than its file name), @see Matchers.h
+    /// - Sink provides `void Accept(const std::string &match, int score)`, `void Flush()` (called once per buffer),
+    ///   `static constexpr bool REPORTS_PATHS`, and accessors for any ranked or sorted results it keeps, @see ResultSinks.h
+    /// Note: Object is designed to pass buffers back to consumer via FinishedCallback to allow for multi-threading if desired.
+    template <typename Matcher, typename Sink>
+    class FilesystemHaystack : public Haystack
     {
-    public:
-        /// Callback definition indicates a matching file name that was found, and provides reference that allows search to be terminated once all buffers have been processed.
-        typedef std::function<void(const std::string &match)> ResultsCallback;
-        /// Callback definition which indicates when the specified thread has has finished processing the specified buffer in @see FilesystemHaystack::FindNeedles
-        typedef std::function<void(std::shared_ptr<FileNames> buffer)> FinishedBufferCallback;
-    
     private:
-        std::string m_path {""};
-        std::string m_needle {""};
+        Matcher m_matcher;
+        Sink m_sink;
         std::atomic<bool> m_terminateSearch{ false };
-        ResultsCallback m_resultsCallback;
         FinishedBufferCallback m_finishedCallback;
         std::unique_ptr<ThreadSafeQueue<std::shared_ptr<FileNames>>> m_buffersToProcess{std::make_unique<ThreadSafeQueue<std::shared_ptr<FileNames>>>()};
 
+        /// Runs the matcher over every entry in the buffer, passing matches to the sink.
+        void SearchBuffer(const FileNames &buffer);
+
+        /// Runs the matcher over the file names (or paths) held in the buffer as strings.
+        void SearchNames(const FileNames &buffer);
+
+        /// Runs the matcher over the names of the buffer's ranges of entries in its @see DirectoryTree, rebuilding full paths from the tree only
+        /// where the matcher or sink needs them.
+        void SearchTreeEntries(const FileNames &buffer);
+
+        /// Runs a matcher that searches paths (e.g. file contents) over every path specified, several files at once on the shared @see WorkerPool,
+        /// and then passes the matches to the sink in the order of paths.
+        void SearchPaths(const std::vector<std::string> &paths);
+
     public:
-    
+
         FilesystemHaystack() = delete;
 
-        FilesystemHaystack(const std::string &path, const std::string &needle, ResultsCallback resultscallback = nullptr, FinishedBufferCallback finishedCallback = nullptr);
+        FilesystemHaystack(Matcher matcher, Sink sink, FinishedBufferCallback finishedCallback);
+
+        void EnqueueBufferToProcess(std::shared_ptr<FileNames> buffer) override;
+
+        void FindNeedles() override;
+
+        void Stop() override;
 
-        /// Enqueues a buffer for processing, which will be picked up by the FindNeedles method and searched for matching substrings
-        void EnqueueBufferToProcess(std::shared_ptr<FileNames> buffer);
-    
-        /// Iterate through all files and subdirectories specified by path to find needle specified, if  results
-        /// are found they will be passed via callback method, which will update whether this thread should terminate or not
-        /// once it's called.
-        void FindNeedles();
+        const RankedResults *Ranked() const override;
 
-        /// Calling the stop method will terminate the FindNeedles method if it's running.
-        void Stop();
+        const SortedRuns *Sorted() const override;
     };
 }
 
+#include "FilesystemHaystack_p.h"
@@ -0,0 +1,199 @@
+#pragma once
+#include <iostream>
+#include <cassert>
+#include <atomic>
+#include <algorithm>
+#include <vector>
+#include "FileNames.h"
+#include "ThreadSafeQueue.h"
+#include "WorkerPool.h"
+
+namespace fileFinder {
+    template <typename Matcher, typename Sink>
+    FilesystemHaystack<Matcher, Sink>::FilesystemHaystack(Matcher matcher, Sink sink, FinishedBufferCallback finishedCallback) :
+        m_matcher(std::move(matcher)),
+        m_sink(std::move(sink)),
+        m_finishedCallback(finishedCallback)
+    {
+        assert(m_finishedCallback != nullptr);
+    }
+
+    template <typename Matcher, typename Sink>
+    void FilesystemHaystack<Matcher, Sink>::FindNeedles()
+    {
+        // Loop until Stop() is called once every buffer has been processed (or the user quits).
+        while (!m_terminateSearch)
+        {
+            if (m_buffersToProcess->Size() > 0)
+            {
+                auto readOnlyBuffer = m_buffersToProcess->Dequeue();
+                SearchBuffer(*readOnlyBuffer);
+                m_finishedCallback(readOnlyBuffer);
+            }
+
+            // TODO: We could probably use a wait condition here...
+            std::this_thread::yield();
+        }
+    }
+
+    template <typename Matcher, typename Sink>
+    void FilesystemHaystack<Matcher, Sink>::SearchBuffer(const FileNames &buffer)
+    {
+        try
+        {
+            if (buffer.Tree != nullptr)
+            {
+                SearchTreeEntries(buffer);
+            }
+            else
+            {
+                SearchNames(buffer);
+            }
+            m_sink.Flush();
+        }
+        catch (const std::bad_alloc &ex)
+        {
+            std::cout << " Error bad allocation caught in " << __FILE__ << " at line " << __LINE__ << std::endl;
+            std::cout << " Exception: " << ex.what() << std::endl;
+            std::terminate();
+        }
+    }
+
+    template <typename Matcher, typename Sink>
+    void FilesystemHaystack<Matcher, Sink>::SearchNames(const FileNames &buffer)
+    {
+        // Content matchers open each file by its full path, everything else only needs the file name
+        if constexpr (Matcher::SEARCHES_PATHS)
+        {
+            SearchPaths(*buffer.Paths);
+            return;
+        }
+
+        // Sinks that need to tell files apart are given full paths whatever the matcher searched
+        const std::vector<std::string> &entries = *buffer.Buffer;
+        const std::vector<std::string> &reported = Sink::REPORTS_PATHS ? *buffer.Paths : *buffer.Buffer;
+
+        for (size_t ix = 0; ix < entries.size(); ix++)
+        {
+            int score = 0;
+            if (m_matcher.Matches(entries[ix], score))
+            {
+                m_sink.Accept(reported[ix], score);
+            }
+
+            if (m_terminateSearch)
+            {
+                break;
+            }
+        }
+    }
+
+    template <typename Matcher, typename Sink>
+    void FilesystemHaystack<Matcher, Sink>::SearchTreeEntries(const FileNames &buffer)
+    {
+        const DirectoryTree &tree = *buffer.Tree;
+        if constexpr (Matcher::SEARCHES_PATHS)
+        {
+            // Content matchers open each file by its full path, which costs far more than rebuilding it
+            std::vector<std::string> paths;
+            paths.reserve(buffer.EntryCount);
+            for (auto &range : *buffer.EntryRanges)
+            {
+                for (auto id = range.first; id < range.second; id++)
+                {
+                    paths.push_back(tree.FullPath(id));
+                }
+            }
+            SearchPaths(paths);
+            return;
+        }
+
+        for (auto &range : *buffer.EntryRanges)
+        {
+            // Only matches reported by path pay for rebuilding it
+            tree.ForEachName(range.first, range.second,
+                [this, &tree](DirectoryTree::EntryId id, const std::string &name)
+                {
+                    int score = 0;
+                    if (m_matcher.Matches(name, score))
+                    {
+                        if constexpr (Sink::REPORTS_PATHS)
+                        {
+                            m_sink.Accept(tree.FullPath(id), score);
+                        }
+                        else
+                        {
+                            m_sink.Accept(name, score);
+                        }
+                    }
+                }
+            );
+
+            if (m_terminateSearch)
+            {
+                break;
+            }
+        }
+    }
+
+    template <typename Matcher, typename Sink>
+    void FilesystemHaystack<Matcher, Sink>::SearchPaths(const std::vector<std::string> &paths)
+    {
+        // Workers pull the next file from a shared counter, and this thread scans files too, so the buffer is still finished if every pool
+        // thread is busy. Sinks aren't thread safe, so matches are only recorded here and passed to the sink once every file has been scanned.
+        std::vector<char> matched(paths.size(), 0);
+        std::vector<int> scores(paths.size(), 0);
+        std::atomic<size_t> nextPath{ 0 };
+        auto scanPaths = [&]()
+        {
+            for (size_t ix = nextPath++; ix < paths.size() && !m_terminateSearch; ix = nextPath++)
+            {
+                matched[ix] = m_matcher.Matches(paths[ix], scores[ix]) ? 1 : 0;
+            }
+        };
+
+        size_t workerCount = std::min<size_t>(paths.size(), std::max(1u, std::thread::hardware_concurrency()));
+        std::vector<std::future<void>> workers;
+        for (size_t ix = 1; ix < workerCount; ix++)
+        {
+            workers.push_back(WorkerPool::Shared().Run(scanPaths));
+        }
+        scanPaths();
+        for (auto &worker : workers)
+        {
+            worker.get();
+        }
+
+        for (size_t ix = 0; ix < paths.size(); ix++)
+        {
+            if (matched[ix])
+            {
+                m_sink.Accept(paths[ix], scores[ix]);
+            }
+        }
+    }
+
+    template <typename Matcher, typename Sink>
+    void FilesystemHaystack<Matcher, Sink>::EnqueueBufferToProcess(std::shared_ptr<FileNames> buffer)
+    {
+        m_buffersToProcess->Enqueue(buffer);
+    }
+
+    template <typename Matcher, typename Sink>
+    void FilesystemHaystack<Matcher, Sink>::Stop()
+    {
+        m_terminateSearch.exchange(true);
+    }
+
+    template <typename Matcher, typename Sink>
+    const RankedResults *FilesystemHaystack<Matcher, Sink>::Ranked() const
+    {
+        return m_sink.Ranked();
+    }
+
+    template <typename Matcher, typename Sink>
+    const SortedRuns *FilesystemHaystack<Matcher, Sink>::Sorted() const
+    {
+        return m_sink.Sorted();
+    }
+}
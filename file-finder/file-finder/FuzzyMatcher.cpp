@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <numeric>
+#include "Matchers.h"
+#include "FuzzyMatcher.h"
+
+using namespace std;
+using namespace fileFinder;
+
+FuzzyMatcher::FuzzyMatcher(const std::string &needle, int maxDistance, bool ignoreCase /*= false*/) :
+    m_needle(needle),
+    m_maxDistance(maxDistance < 0 ? 0 : maxDistance),
+    m_ignoreCase(ignoreCase)
+{
+    // Each character's mask has bit i set where needle[i] is that character, so a single lookup gives the match vector for a whole column.
+    // Ignoring case just means both cases of a letter share the same mask.
+    if (m_ignoreCase)
+    {
+        std::transform(m_needle.begin(), m_needle.end(), m_needle.begin(), FoldCase);
+    }
+    for (size_t ix = 0; ix < m_needle.size() && ix < WORD_BITS; ix++)
+    {
+        m_patternMasks[static_cast<unsigned char>(m_needle[ix])] |= (uint64_t(1) << ix);
+    }
+    if (m_ignoreCase)
+    {
+        for (char c = 'A'; c <= 'Z'; c++)
+        {
+            m_patternMasks[static_cast<unsigned char>(c)] = m_patternMasks[static_cast<unsigned char>(FoldCase(c))];
+        }
+    }
+}
+
+int FuzzyMatcher::Distance(const char *begin, const char *end) const
+{
+    if (m_needle.size() <= WORD_BITS)
+    {
+        return BitParallelDistance(begin, end);
+    }
+    return DynamicProgrammingDistance(begin, end);
+}
+
+int FuzzyMatcher::BitParallelDistance(const char *begin, const char *end) const
+{
+    // Pv/Mv hold the vertical deltas (+1/-1) of the current column, and score tracks the bottom cell, i.e. the distance between the whole
+    // needle and the best substring ending at the current character. The top row is always zero since a match may start anywhere.
+    const int needleLength = static_cast<int>(m_needle.size());
+    if (needleLength == 0)
+    {
+        return 0;
+    }
+
+    const uint64_t lastBit = uint64_t(1) << (needleLength - 1);
+    uint64_t positiveVertical = ~uint64_t(0);
+    uint64_t negativeVertical = 0;
+    int score = needleLength;
+    int bestScore = needleLength;
+
+    for (const char *cursor = begin; cursor != end && bestScore > 0; ++cursor)
+    {
+        uint64_t equal = m_patternMasks[static_cast<unsigned char>(*cursor)];
+        uint64_t crossVertical = equal | negativeVertical;
+        uint64_t crossHorizontal = (((equal & positiveVertical) + positiveVertical) ^ positiveVertical) | equal;
+        uint64_t positiveHorizontal = negativeVertical | ~(crossHorizontal | positiveVertical);
+        uint64_t negativeHorizontal = positiveVertical & crossHorizontal;
+
+        if (positiveHorizontal & lastBit)
+        {
+            score++;
+        }
+        else if (negativeHorizontal & lastBit)
+        {
+            score--;
+        }
+
+        positiveHorizontal <<= 1;
+        negativeHorizontal <<= 1;
+        positiveVertical = negativeHorizontal | ~(crossVertical | positiveHorizontal);
+        negativeVertical = positiveHorizontal & crossVertical;
+
+        bestScore = std::min(bestScore, score);
+    }
+
+    return (bestScore > m_maxDistance) ? m_maxDistance + 1 : bestScore;
+}
+
+int FuzzyMatcher::DynamicProgrammingDistance(const char *begin, const char *end) const
+{
+    // column[i] is the distance between the first i characters of the needle and the best substring ending at the current character
+    std::vector<int> column(m_needle.size() + 1);
+    std::iota(column.begin(), column.end(), 0);
+    int bestScore = static_cast<int>(m_needle.size());
+
+    for (const char *cursor = begin; cursor != end && bestScore > 0; ++cursor)
+    {
+        int diagonal = 0;
+        char c = m_ignoreCase ? FoldCase(*cursor) : *cursor;
+        for (size_t ix = 1; ix <= m_needle.size(); ix++)
+        {
+            int above = column[ix];
+            int substitution = diagonal + ((m_needle[ix - 1] == c) ? 0 : 1);
+            column[ix] = std::min({ substitution, above + 1, column[ix - 1] + 1 });
+            diagonal = above;
+        }
+        bestScore = std::min(bestScore, column.back());
+    }
+
+    return (bestScore > m_maxDistance) ? m_maxDistance + 1 : bestScore;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <array>
+#include <cstdint>
+
+namespace fileFinder
+{
+    /// FuzzyMatcher finds the smallest edit distance between a needle and any substring of a haystack, giving up once it's certain the
+    /// distance exceeds a maximum. Needles of up to 64 characters use Myers' bit-parallel algorithm, which keeps a whole column of the edit
+    /// distance matrix in a pair of machine words and so costs a handful of word operations per haystack character. Longer needles fall back
+    /// to the classic dynamic programming recurrence.
+    /// sample usage:
+    /// FuzzyMatcher matcher("report", 2);
+    /// int distance = matcher.Distance(name.data(), name.data() + name.size());
+    /// if (distance <= matcher.MaxDistance()) { ... }
+    class FuzzyMatcher
+    {
+    private:
+        static constexpr size_t WORD_BITS{ 64 };
+        std::string m_needle;
+        int m_maxDistance{ 0 };
+        bool m_ignoreCase{ false };
+        std::array<uint64_t, 256> m_patternMasks{};
+
+        /// Myers' algorithm for needles that fit in a single machine word.
+        int BitParallelDistance(const char *begin, const char *end) const;
+
+        /// Column-at-a-time dynamic programming for needles longer than a machine word.
+        int DynamicProgrammingDistance(const char *begin, const char *end) const;
+
+    public:
+
+        FuzzyMatcher() = delete;
+
+        /// Accepts the needle to search for and the largest edit distance (insertions, deletions, and substitutions) that still counts as a match.
+        /// If ignoreCase is true, ASCII letters match regardless of case.
+        FuzzyMatcher(const std::string &needle, int maxDistance, bool ignoreCase = false);
+
+        /// Matcher policy for @see FilesystemHaystack, file names are matched and scored by their edit distance
+        static constexpr bool SEARCHES_PATHS{ false };
+
+        /// Returns true if entry is within MaxDistance() of the needle, setting score to its edit distance
+        bool Matches(const std::string &entry, int &score) const
+        {
+            score = Distance(entry.data(), entry.data() + entry.size());
+            return score <= m_maxDistance;
+        }
+
+        /// Returns the smallest edit distance between the needle and any substring of [begin, end), or MaxDistance() + 1 if every substring
+        /// is further away than MaxDistance().
+        int Distance(const char *begin, const char *end) const;
+
+        /// Returns the largest edit distance that counts as a match
+        int MaxDistance() const { return m_maxDistance; }
+    };
+}
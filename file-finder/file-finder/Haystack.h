@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <functional>
+#include <memory>
+#include "SearchOptions.h"
+
+namespace fileFinder
+{
+    struct FileNames;
+    class ResultSpool;
+    class RankedResults;
+    class SortedRuns;
+
+    /// Haystack is the interface @see ResultsMonitor uses to drive a search thread, regardless of which matcher and result sink it was built with.
+    /// Each call through this interface is made once per buffer (or once per search), never once per file name; the per-name work happens inside
+    /// @see FilesystemHaystack, which is specialized at compile time for each matcher and sink. Use @see Haystack::Create to build one.
+    class Haystack
+    {
+    public:
+        /// Callback definition which indicates when the specified thread has has finished processing the specified buffer in @see Haystack::FindNeedles
+        typedef std::function<void(std::shared_ptr<FileNames> buffer)> FinishedBufferCallback;
+
+        virtual ~Haystack() = default;
+
+        /// Enqueues a buffer for processing, which will be picked up by the FindNeedles method and searched for matching substrings
+        virtual void EnqueueBufferToProcess(std::shared_ptr<FileNames> buffer) = 0;
+
+        /// Searches each buffer enqueued until Stop is called, passing matches to the haystack's result sink and each buffer to FinishedBufferCallback once it's been searched.
+        virtual void FindNeedles() = 0;
+
+        /// Calling the stop method will terminate the FindNeedles method if it's running.
+        virtual void Stop() = 0;
+
+        /// Returns the best matches found if the haystack ranks its results (fuzzy searches), otherwise nullptr. Should only be called once FindNeedles has returned.
+        virtual const RankedResults *Ranked() const = 0;
+
+        /// Returns the matches found, in sorted runs, if the haystack sorts its results (@see SearchOptions::Sorted), otherwise nullptr. Should only be called once FindNeedles has returned.
+        virtual const SortedRuns *Sorted() const = 0;
+
+        /// Selects the matcher and result sink for the options specified, once per query, and returns a haystack specialized for them.
+        /// Multi-pattern searches @see SearchOptions::MultiPattern search for all of the needles at once, otherwise needles should contain a single needle.
+        /// A single needle is always searched for with Boyer-Moore, even in a multi-pattern search.
+        /// Matches that aren't ranked or sorted are added to results a buffer at a time.
+        static std::unique_ptr<Haystack> Create(const std::vector<std::string> &needles, const SearchOptions &options, ResultSpool *results,
+            FinishedBufferCallback finishedCallback);
+    };
+}
@@ -0,0 +1,136 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+using namespace std;
+using namespace fileFinder;
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string &path)
+{
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return;
+    }
+    m_fileHandle = file;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        Close();
+        return;
+    }
+
+    m_mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_mappingHandle == nullptr)
+    {
+        Close();
+        return;
+    }
+
+    m_data = static_cast<const char *>(MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (m_data == nullptr)
+    {
+        Close();
+        return;
+    }
+    m_size = static_cast<size_t>(size.QuadPart);
+}
+
+void MappedFile::Close()
+{
+    if (m_data != nullptr)
+    {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mappingHandle != nullptr)
+    {
+        CloseHandle(m_mappingHandle);
+    }
+    if (m_fileHandle != nullptr)
+    {
+        CloseHandle(m_fileHandle);
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_mappingHandle = nullptr;
+    m_fileHandle = nullptr;
+}
+
+#else
+
+MappedFile::MappedFile(const std::string &path)
+{
+    m_fileDescriptor = open(path.c_str(), O_RDONLY);
+    if (m_fileDescriptor < 0)
+    {
+        return;
+    }
+
+    struct stat status;
+    if (fstat(m_fileDescriptor, &status) != 0 || !S_ISREG(status.st_mode) || status.st_size == 0)
+    {
+        Close();
+        return;
+    }
+
+    void *data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, m_fileDescriptor, 0);
+    if (data == MAP_FAILED)
+    {
+        Close();
+        return;
+    }
+
+    // We read each mapping front to back (or in a handful of large chunks), so let the kernel read ahead aggressively.
+    madvise(data, static_cast<size_t>(status.st_size), MADV_SEQUENTIAL);
+    m_data = static_cast<const char *>(data);
+    m_size = static_cast<size_t>(status.st_size);
+}
+
+void MappedFile::Close()
+{
+    if (m_data != nullptr)
+    {
+        munmap(const_cast<char *>(m_data), m_size);
+    }
+    if (m_fileDescriptor >= 0)
+    {
+        close(m_fileDescriptor);
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_fileDescriptor = -1;
+}
+
+#endif
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::IsValid() const
+{
+    return m_data != nullptr;
+}
+
+const char *MappedFile::Data() const
+{
+    return m_data;
+}
+
+size_t MappedFile::Size() const
+{
+    return m_size;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+namespace fileFinder
+{
+    /// MappedFile provides a read-only memory mapping of a file's contents so it can be searched in place without copying it into our own buffers.
+    /// sample usage:
+    /// MappedFile file(path);
+    /// if (file.IsValid())
+    /// {
+    ///     std::search(file.Data(), file.Data() + file.Size(), ...);
+    /// }
+    class MappedFile
+    {
+    private:
+        const char *m_data{ nullptr };
+        size_t m_size{ 0 };
+#ifdef _WIN32
+        void *m_fileHandle{ nullptr };
+        void *m_mappingHandle{ nullptr };
+#else
+        int m_fileDescriptor{ -1 };
+#endif
+
+        /// Releases the mapping and any handles held, leaving the object invalid.
+        void Close();
+
+    public:
+
+        MappedFile() = delete;
+
+        /// Maps the file specified by path, check @see MappedFile::IsValid to see if the mapping succeeded.
+        explicit MappedFile(const std::string &path);
+
+        /// Copying this object is not part of our use case, so we'll set it up as non-copyable
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        ~MappedFile();
+
+        /// Returns true if the file was opened and mapped successfully (empty files are never mapped, and so are never valid)
+        bool IsValid() const;
+
+        /// Returns a pointer to the first byte of the mapped file, or nullptr if the mapping isn't valid
+        const char *Data() const;
+
+        /// Returns the size in bytes of the mapped file
+        size_t Size() const;
+    };
+}
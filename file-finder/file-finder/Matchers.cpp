@@ -0,0 +1,82 @@
+#include <queue>
+#include "Matchers.h"
+
+using namespace std;
+using namespace fileFinder;
+
+MultiPatternMatcher::MultiPatternMatcher(const std::vector<std::string> &needles, bool ignoreCase)
+{
+    // Build a trie of the needles (folded to lower case if we're ignoring case), with -1 marking transitions that don't exist yet
+    m_transitions.assign(ALPHABET_SIZE, -1);
+    m_accepting.push_back(0);
+    for (auto &needle : needles)
+    {
+        int32_t state = 0;
+        for (char c : needle)
+        {
+            auto byte = static_cast<unsigned char>(ignoreCase ? FoldCase(c) : c);
+            auto &next = m_transitions[static_cast<size_t>(state) * ALPHABET_SIZE + byte];
+            if (next < 0)
+            {
+                next = static_cast<int32_t>(m_accepting.size());
+                m_accepting.push_back(0);
+                m_transitions.resize(m_transitions.size() + ALPHABET_SIZE, -1);
+            }
+            state = m_transitions[static_cast<size_t>(state) * ALPHABET_SIZE + byte];
+        }
+        m_accepting[state] = 1;
+        m_maxMatchLength = std::max(m_maxMatchLength, needle.size());
+    }
+
+    // Breadth first, work out each state's failure state (the longest proper suffix of it that's also in the trie), and replace each missing
+    // transition with the failure state's transition, so matching never has to follow failure links at runtime. A state also accepts if its
+    // failure state does, since that means a shorter needle ends here.
+    std::vector<int32_t> failure(m_accepting.size(), 0);
+    std::queue<int32_t> pending;
+    for (size_t byte = 0; byte < ALPHABET_SIZE; byte++)
+    {
+        auto &next = m_transitions[byte];
+        if (next < 0)
+        {
+            next = 0;
+        }
+        else
+        {
+            pending.push(next);
+        }
+    }
+
+    while (!pending.empty())
+    {
+        int32_t state = pending.front();
+        pending.pop();
+        m_accepting[state] |= m_accepting[failure[state]];
+
+        for (size_t byte = 0; byte < ALPHABET_SIZE; byte++)
+        {
+            auto &next = m_transitions[static_cast<size_t>(state) * ALPHABET_SIZE + byte];
+            auto fallback = m_transitions[static_cast<size_t>(failure[state]) * ALPHABET_SIZE + byte];
+            if (next < 0)
+            {
+                next = fallback;
+            }
+            else
+            {
+                failure[next] = fallback;
+                pending.push(next);
+            }
+        }
+    }
+
+    // The trie only has lower case edges when ignoring case, so upper case bytes simply follow the same transitions as their lower case letters
+    if (ignoreCase)
+    {
+        for (size_t state = 0; state < m_accepting.size(); state++)
+        {
+            for (char c = 'A'; c <= 'Z'; c++)
+            {
+                m_transitions[state * ALPHABET_SIZE + static_cast<unsigned char>(c)] = m_transitions[state * ALPHABET_SIZE + static_cast<unsigned char>(FoldCase(c))];
+            }
+        }
+    }
+}
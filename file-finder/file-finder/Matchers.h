@@ -0,0 +1,151 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <array>
+#include <memory>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+#include <cstdint>
+#include "FileContentScanner.h"
+
+namespace fileFinder
+{
+    /// Matcher policies for @see FilesystemHaystack. Every matcher provides:
+    /// - `static constexpr bool SEARCHES_PATHS`, true if Matches should be given each entry's full path rather than its file name
+    /// - `bool Matches(const std::string &entry, int &score) const`, which sets score (lower is better, exact matchers always score 0)
+    /// Matchers that can also search file contents provide `bool MatchesRange(const char *begin, const char *end) const` and
+    /// `size_t MaxMatchLength() const`, so they can be wrapped in a @see ContentMatcher.
+
+    /// Folds ASCII upper case letters to lower case, leaving every other byte (including UTF-8 sequences) unchanged
+    inline char FoldCase(char c)
+    {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    /// Hash and equality for case-folded Boyer-Moore searches
+    struct FoldedCharHash
+    {
+        size_t operator()(char c) const { return static_cast<unsigned char>(FoldCase(c)); }
+    };
+
+    struct FoldedCharEqual
+    {
+        bool operator()(char left, char right) const { return FoldCase(left) == FoldCase(right); }
+    };
+
+    /// Matches entries containing a single needle, using Boyer-Moore. IgnoreCase selects a case-folded searcher at compile time, so exact
+    /// searches don't pay for folding.
+    template <bool IgnoreCase>
+    class SubstringMatcher
+    {
+    private:
+        typedef typename std::conditional<IgnoreCase,
+            std::boyer_moore_searcher<const char *, FoldedCharHash, FoldedCharEqual>,
+            std::boyer_moore_searcher<const char *>>::type Searcher;
+
+        // The searcher keeps pointers into the needle, so the needle is shared rather than copied when the matcher is moved into its haystack
+        std::shared_ptr<const std::string> m_needle;
+        Searcher m_searcher;
+
+    public:
+        static constexpr bool SEARCHES_PATHS{ false };
+
+        explicit SubstringMatcher(const std::string &needle) :
+            m_needle(std::make_shared<const std::string>(needle)),
+            m_searcher(m_needle->data(), m_needle->data() + m_needle->size())
+        {
+        }
+
+        bool MatchesRange(const char *begin, const char *end) const
+        {
+            return std::search(begin, end, m_searcher) != end;
+        }
+
+        bool Matches(const std::string &entry, int &score) const
+        {
+            score = 0;
+            return MatchesRange(entry.data(), entry.data() + entry.size());
+        }
+
+        size_t MaxMatchLength() const
+        {
+            return m_needle->size();
+        }
+    };
+
+    /// Matches entries containing any of several needles in a single pass, using an Aho-Corasick automaton flattened into a full transition
+    /// table, so each byte costs one table lookup whatever the number of needles. Case folding is applied when the table is built (upper and
+    /// lower case bytes lead to the same state) and so costs nothing per byte.
+    class MultiPatternMatcher
+    {
+    private:
+        static constexpr size_t ALPHABET_SIZE{ 256 };
+        std::vector<int32_t> m_transitions;
+        std::vector<uint8_t> m_accepting;
+        size_t m_maxMatchLength{ 0 };
+
+    public:
+        static constexpr bool SEARCHES_PATHS{ false };
+
+        MultiPatternMatcher(const std::vector<std::string> &needles, bool ignoreCase);
+
+        bool MatchesRange(const char *begin, const char *end) const
+        {
+            int32_t state = 0;
+            if (m_accepting[state])
+            {
+                return true;
+            }
+            for (const char *cursor = begin; cursor != end; ++cursor)
+            {
+                state = m_transitions[static_cast<size_t>(state) * ALPHABET_SIZE + static_cast<unsigned char>(*cursor)];
+                if (m_accepting[state])
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool Matches(const std::string &entry, int &score) const
+        {
+            score = 0;
+            return MatchesRange(entry.data(), entry.data() + entry.size());
+        }
+
+        size_t MaxMatchLength() const
+        {
+            return m_maxMatchLength;
+        }
+    };
+
+    /// Matches files whose contents are matched by the wrapped matcher, @see FileContentScanner
+    template <typename Inner>
+    class ContentMatcher
+    {
+    private:
+        std::shared_ptr<const Inner> m_inner;
+        std::shared_ptr<const FileContentScanner> m_scanner;
+
+    public:
+        static constexpr bool SEARCHES_PATHS{ true };
+
+        explicit ContentMatcher(Inner inner) :
+            m_inner(std::make_shared<const Inner>(std::move(inner))),
+            m_scanner(std::make_shared<const FileContentScanner>(
+                [inner = m_inner](const char *begin, const char *end)
+                {
+                    return inner->MatchesRange(begin, end);
+                },
+                m_inner->MaxMatchLength()))
+        {
+        }
+
+        bool Matches(const std::string &path, int &score) const
+        {
+            score = 0;
+            return m_scanner->Matches(path);
+        }
+    };
+}
@@ -0,0 +1,105 @@
+#include <iostream>
+#include <algorithm>
+#include "RankedResults.h"
+
+using namespace std;
+using namespace fileFinder;
+
+RankedResults::RankedResults(size_t capacity) :
+    m_capacity(capacity)
+{
+}
+
+bool RankedResults::IsBetter(const Result &left, const Result &right)
+{
+    if (left.Score != right.Score)
+    {
+        return left.Score < right.Score;
+    }
+    return left.Match < right.Match;
+}
+
+bool RankedResults::WouldKeep(int score) const
+{
+    if (m_heap.size() < m_capacity)
+    {
+        return true;
+    }
+    return m_capacity > 0 && score <= m_heap.front().Score;
+}
+
+void RankedResults::Offer(int score, const std::string &match)
+{
+    if (!WouldKeep(score))
+    {
+        return;
+    }
+
+    try
+    {
+        Result result{ score, match };
+        if (m_heap.size() < m_capacity)
+        {
+            m_heap.push_back(std::move(result));
+            std::push_heap(m_heap.begin(), m_heap.end(), IsBetter);
+        }
+        else if (IsBetter(result, m_heap.front()))
+        {
+            // Replace the worst result we're holding
+            std::pop_heap(m_heap.begin(), m_heap.end(), IsBetter);
+            m_heap.back() = std::move(result);
+            std::push_heap(m_heap.begin(), m_heap.end(), IsBetter);
+        }
+    }
+    catch (const std::bad_alloc &ex)
+    {
+        std::cout << " Error bad allocation caught in " << __FILE__ << " at line " << __LINE__ << endl;
+        std::cout << " Exception: " << ex.what() << endl;
+        std::terminate();
+    }
+}
+
+void RankedResults::Merge(const RankedResults &other)
+{
+    try
+    {
+        // Offer doesn't look for duplicates, that would cost every match a lookup, so this is where a match kept more than once (by this
+        // heap and other, e.g. a file matched by two needles) is reduced to its best score. Sorting by match puts each match's best score first.
+        std::vector<Result> combined = m_heap;
+        combined.insert(combined.end(), other.m_heap.begin(), other.m_heap.end());
+        std::sort(combined.begin(), combined.end(),
+            [](const Result &left, const Result &right)
+            {
+                return (left.Match != right.Match) ? left.Match < right.Match : left.Score < right.Score;
+            }
+        );
+        combined.erase(std::unique(combined.begin(), combined.end(),
+            [](const Result &left, const Result &right)
+            {
+                return left.Match == right.Match;
+            }
+        ), combined.end());
+
+        // Keep the best capacity of what's left
+        std::sort(combined.begin(), combined.end(), IsBetter);
+        if (combined.size() > m_capacity)
+        {
+            combined.resize(m_capacity);
+        }
+        std::make_heap(combined.begin(), combined.end(), IsBetter);
+        m_heap = std::move(combined);
+    }
+    catch (const std::bad_alloc &ex)
+    {
+        std::cout << " Error bad allocation caught in " << __FILE__ << " at line " << __LINE__ << endl;
+        std::cout << " Exception: " << ex.what() << endl;
+        std::terminate();
+    }
+}
+
+std::vector<RankedResults::Result> RankedResults::Sorted() const
+{
+    std::vector<Result> sorted = m_heap;
+    std::sort_heap(sorted.begin(), sorted.end(), IsBetter);
+    return sorted;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstddef>
+
+namespace fileFinder
+{
+    /// RankedResults keeps the best K scored matches offered to it in a bounded max-heap (lowest score is best), so each worker can rank its
+    /// own matches without any locking and without holding on to more than K of them. Workers' results are combined with @see RankedResults::Merge
+    /// once the search is complete.
+    class RankedResults
+    {
+    public:
+        /// A single ranked match, lower scores are better
+        struct Result
+        {
+            int Score{ 0 };
+            std::string Match;
+        };
+
+    private:
+        size_t m_capacity{ 0 };
+        std::vector<Result> m_heap;
+
+        /// Heap ordering that keeps the worst result (highest score, then last alphabetically) on top, where it can be evicted cheaply
+        static bool IsBetter(const Result &left, const Result &right);
+
+    public:
+
+        RankedResults() = delete;
+
+        /// Accepts the number of results to keep
+        explicit RankedResults(size_t capacity);
+
+        /// Returns true if a result with the score specified would be kept, so callers can avoid building a result that would be discarded
+        bool WouldKeep(int score) const;
+
+        /// Offers a result, keeping it if there are fewer than capacity results or it's better than the worst result kept. Offer doesn't check
+        /// whether the match is already kept, so it stays O(log K) per match, duplicates are removed by @see RankedResults::Merge
+        void Offer(int score, const std::string &match);
+
+        /// Combines the results kept by other with our own, keeping each match once (with its best score, e.g. a file matched by two needles)
+        void Merge(const RankedResults &other);
+
+        /// Returns the results kept, best first
+        std::vector<Result> Sorted() const;
+    };
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstddef>
+#include "ResultSpool.h"
+#include "RankedResults.h"
+#include "SortedRuns.h"
+
+namespace fileFinder
+{
+    /// Result sink policies for @see FilesystemHaystack. Every sink provides:
+    /// - `static constexpr bool REPORTS_PATHS`, true if Accept should be given each match's full path whatever the matcher searched
+    /// - `void Accept(const std::string &match, int score)`, called for each match found
+    /// - `void Flush()`, called once each buffer has been searched
+    /// - `const RankedResults *Ranked() const`, which returns the sink's ranked results if it ranks them, otherwise nullptr
+    /// - `const SortedRuns *Sorted() const`, which returns the sink's sorted results if it sorts them, otherwise nullptr
+
+    /// Collects a buffer's worth of matches and then adds them to the shared @see ResultSpool with a single lock, rather than taking the lock
+    /// once per match.
+    class QueueSink
+    {
+    private:
+        ResultSpool *m_results{ nullptr };
+        std::vector<std::string> m_batch;
+
+    public:
+        static constexpr bool REPORTS_PATHS{ false };
+
+        explicit QueueSink(ResultSpool *results) :
+            m_results(results)
+        {
+        }
+
+        void Accept(const std::string &match, int /*score*/)
+        {
+            m_batch.push_back(match);
+        }
+
+        void Flush()
+        {
+            if (!m_batch.empty())
+            {
+                m_results->EnqueueBatch(m_batch);
+            }
+        }
+
+        const RankedResults *Ranked() const
+        {
+            return nullptr;
+        }
+
+        const SortedRuns *Sorted() const
+        {
+            return nullptr;
+        }
+    };
+
+    /// Keeps the best scored matches in a bounded heap owned by the haystack, @see RankedResults. Matches are reported by full path, so the same
+    /// file matched by several needles (in different haystacks) is ranked once when the heaps are merged, while files that only share a name aren't.
+    class RankedSink
+    {
+    private:
+        RankedResults m_rankedResults;
+
+    public:
+        static constexpr bool REPORTS_PATHS{ true };
+
+        explicit RankedSink(size_t capacity) :
+            m_rankedResults(capacity)
+        {
+        }
+
+        void Accept(const std::string &match, int score)
+        {
+            if (m_rankedResults.WouldKeep(score))
+            {
+                m_rankedResults.Offer(score, match);
+            }
+        }
+
+        void Flush()
+        {
+        }
+
+        const RankedResults *Ranked() const
+        {
+            return &m_rankedResults;
+        }
+
+        const SortedRuns *Sorted() const
+        {
+            return nullptr;
+        }
+    };
+
+    /// Keeps each buffer's matches as a sorted run owned by the haystack, @see SortedRuns. Matches are reported by full path, so the same file
+    /// matched by several needles (in different haystacks) can be recognized as a duplicate when the runs are merged.
+    class SortedSink
+    {
+    private:
+        std::vector<std::string> m_batch;
+        SortedRuns m_sortedRuns;
+
+    public:
+        static constexpr bool REPORTS_PATHS{ true };
+
+        void Accept(const std::string &match, int /*score*/)
+        {
+            m_batch.push_back(match);
+        }
+
+        void Flush()
+        {
+            m_sortedRuns.AddRun(m_batch);
+        }
+
+        const RankedResults *Ranked() const
+        {
+            return nullptr;
+        }
+
+        const SortedRuns *Sorted() const
+        {
+            return &m_sortedRuns;
+        }
+    };
+}
@@ -0,0 +1,179 @@
+#include <iostream>
+#include "ResultSpool.h"
+
+using namespace std;
+using namespace fileFinder;
+
+namespace
+{
+    // Each result is stored as its length (a little endian base 128 varint) followed by its bytes, so most paths cost a single byte of overhead
+    const size_t MAX_VARINT_BYTES{ 10 };
+
+    // Approximates what a result costs in memory, the string object itself plus its characters
+    size_t ResultMemoryUsage(const std::string &result)
+    {
+        return sizeof(std::string) + result.size();
+    }
+}
+
+ResultSpool::ResultSpool(size_t memoryBudget) :
+    m_memoryBudget(memoryBudget)
+{
+}
+
+ResultSpool::~ResultSpool()
+{
+    if (m_spill.File != nullptr)
+    {
+        std::fclose(m_spill.File);
+    }
+}
+
+void ResultSpool::EnqueueBatch(std::vector<std::string> &batch)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Once anything has spilled, everything after it has to spill too (until the next drain) so results still come back out in order
+    size_t batchUsage = 0;
+    for (auto &result : batch)
+    {
+        batchUsage += ResultMemoryUsage(result);
+    }
+    if (m_memoryBudget > 0 && (m_spill.File != nullptr || m_memoryUsage + batchUsage > m_memoryBudget))
+    {
+        Spill(batch);
+        batch.clear();
+        return;
+    }
+
+    try
+    {
+        for (auto &result : batch)
+        {
+            m_inMemory.push_back(std::move(result));
+        }
+    }
+    catch (const std::bad_alloc &ex)
+    {
+        std::cout << " Error bad allocation caught in " << __FILE__ << " at line " << __LINE__ << endl;
+        std::cout << " Exception: " << ex.what() << endl;
+        std::terminate();
+    }
+    m_memoryUsage += batchUsage;
+    batch.clear();
+}
+
+void ResultSpool::Spill(std::vector<std::string> &batch)
+{
+    if (m_spill.File == nullptr)
+    {
+        m_spill.File = std::tmpfile();
+        if (m_spill.File == nullptr)
+        {
+            std::cout << " Error unable to create a temporary file for results in " << __FILE__ << " at line " << __LINE__ << endl;
+            std::terminate();
+        }
+    }
+
+    unsigned char length[MAX_VARINT_BYTES];
+    for (auto &result : batch)
+    {
+        size_t lengthBytes = 0;
+        size_t value = result.size();
+        do
+        {
+            length[lengthBytes++] = static_cast<unsigned char>((value & 0x7F) | (value > 0x7F ? 0x80 : 0));
+            value >>= 7;
+        } while (value > 0);
+
+        if (std::fwrite(length, 1, lengthBytes, m_spill.File) != lengthBytes || std::fwrite(result.data(), 1, result.size(), m_spill.File) != result.size())
+        {
+            std::cout << " Error unable to write results to a temporary file in " << __FILE__ << " at line " << __LINE__ << endl;
+            std::terminate();
+        }
+        m_spill.Results++;
+        m_totalSpilledResults++;
+        m_totalSpilledBytes += static_cast<int64_t>(lengthBytes + result.size());
+    }
+}
+
+void ResultSpool::Replay(SpillFile &spill, const std::function<void(const std::string&)> &output)
+{
+    std::rewind(spill.File);
+
+    std::string result;
+    for (int64_t ix = 0; ix < spill.Results; ix++)
+    {
+        size_t length = 0;
+        int shift = 0;
+        int byte = 0;
+        do
+        {
+            byte = std::fgetc(spill.File);
+            if (byte == EOF)
+            {
+                std::cout << " Error unable to read results from a temporary file in " << __FILE__ << " at line " << __LINE__ << endl;
+                std::terminate();
+            }
+            length |= static_cast<size_t>(byte & 0x7F) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+
+        result.resize(length);
+        if (length > 0 && std::fread(&result[0], 1, length, spill.File) != length)
+        {
+            std::cout << " Error unable to read results from a temporary file in " << __FILE__ << " at line " << __LINE__ << endl;
+            std::terminate();
+        }
+        output(result);
+    }
+
+    std::fclose(spill.File);
+    spill = SpillFile();
+}
+
+int64_t ResultSpool::Drain(const std::function<void(const std::string&)> &output)
+{
+    // Take everything held so far and release the lock straight away, the search threads start filling a fresh spool while we write these out.
+    // The results we took still count against the budget until we've written them out and freed them, so the spool never holds more than the
+    // budget in memory between the two.
+    std::deque<std::string> inMemory;
+    SpillFile spill;
+    size_t drainedUsage = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        inMemory.swap(m_inMemory);
+        drainedUsage = m_memoryUsage;
+        std::swap(spill, m_spill);
+    }
+
+    for (auto &result : inMemory)
+    {
+        output(result);
+    }
+
+    int64_t drained = static_cast<int64_t>(inMemory.size()) + spill.Results;
+    std::deque<std::string>().swap(inMemory);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_memoryUsage -= drainedUsage;
+    }
+
+    if (spill.File != nullptr)
+    {
+        Replay(spill, output);
+    }
+    return drained;
+}
+
+int64_t ResultSpool::SpilledResults()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_totalSpilledResults;
+}
+
+int64_t ResultSpool::SpilledBytes()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_totalSpilledBytes;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <deque>
+#include <mutex>
+#include <functional>
+#include <cstdio>
+#include <cstdint>
+
+namespace fileFinder
+{
+    /// ResultSpool holds the matches found by the haystacks until they're dumped to the console, keeping at most a fixed number of bytes of them
+    /// in memory. Once the budget is exceeded, further batches are appended to a temporary file as length-prefixed records, and at dump time the
+    /// results in memory are shown first, followed by those in the file, so they come out in the order they were found. Each dump takes the
+    /// results (and the file) it's going to show and releases the lock before writing any of them, so slow output never holds up the search.
+    /// sample usage:
+    /// ResultSpool spool(256 * 1024 * 1024);
+    /// spool.EnqueueBatch(matches);    // from any search thread
+    /// spool.Drain([](const std::string &match) { std::cout << match << std::endl; });
+    class ResultSpool
+    {
+    private:
+        /// A temporary file of spilled results, the file is deleted when it's closed
+        struct SpillFile
+        {
+            std::FILE *File{ nullptr };
+            int64_t Results{ 0 };
+        };
+
+        std::mutex m_mutex;
+        size_t m_memoryBudget{ 0 };
+        size_t m_memoryUsage{ 0 };
+        std::deque<std::string> m_inMemory;
+        SpillFile m_spill;
+        int64_t m_totalSpilledResults{ 0 };
+        int64_t m_totalSpilledBytes{ 0 };
+
+        /// Appends every result in batch to the spill file, opening it if need be, should be called with the lock held
+        void Spill(std::vector<std::string> &batch);
+
+        /// Reads every result back from a spill file in the order it was written, calling output for each, and then closes the file
+        static void Replay(SpillFile &spill, const std::function<void(const std::string&)> &output);
+
+    public:
+        /// Creates a spool that keeps up to memoryBudget bytes of results in memory, a budget of zero keeps every result in memory
+        explicit ResultSpool(size_t memoryBudget);
+
+        ResultSpool() = delete;
+
+        /// Copying this object is not part of our use case, so we'll set it up as non-copyable
+        ResultSpool& operator=(const ResultSpool&) = delete;
+
+        /// Closes (and so deletes) the spill file if there is one
+        ~ResultSpool();
+
+        /// Adds every result in batch to the spool while taking the lock only once, leaving batch empty. Safe to call from any number of threads.
+        void EnqueueBatch(std::vector<std::string> &batch);
+
+        /// Passes every result held to output in the order they were added, returning the number of results. Results added while the drain is
+        /// in progress are kept for the next one, and the results being drained count against the budget until they've all been output (so
+        /// results added meanwhile spill sooner). Should only be called from one thread at a time.
+        int64_t Drain(const std::function<void(const std::string&)> &output);
+
+        /// Returns the total number of results that have been written to disk
+        int64_t SpilledResults();
+
+        /// Returns the total number of bytes that have been written to disk
+        int64_t SpilledBytes();
+    };
+}
@@ -3,31 +3,44 @@
 #include <iostream>
 #include <future>
 #include <chrono>
+#include <limits>
+#include <cstdint>
 #include <conio.h>
 #include "FileNames.h"
 #include "FileNameBuffer.h"
 #include "ThreadSafeQueue.h"
 #include "ResultsMonitor.h"
-#include "FilesystemHaystack.h"
+#include "Haystack.h"
+#include "RankedResults.h"
+#include "ResultSpool.h"
+#include "SortedRuns.h"
 
 using namespace std;
 using namespace std::chrono;
 using namespace fileFinder;
 
-void ResultsMonitor::InitializeHaystacksAndBuffer(const std::string &path, const std::vector<std::string> &needles)
+void ResultsMonitor::InitializeHaystacksAndBuffer(const std::vector<std::string> &roots, const std::vector<std::string> &needles, const WalkOptions &walkOptions, const SearchOptions &searchOptions)
 {
-    // Set up our FileSystemHaystacks with a thread for each substring(needle) that we want to find in them
-    for (auto needle : needles)
+    // Set up our haystacks with a thread for each substring(needle) that we want to find in them, or a single haystack that finds all of them
+    // in one pass for multi-pattern searches (fuzzy searches rank each needle's matches separately, so they always use a haystack per needle)
+    std::vector<std::vector<std::string>> needleGroups;
+    if (searchOptions.MultiPattern && searchOptions.MaxEditDistance < 0)
     {
-        auto newHaystack = std::make_unique<FilesystemHaystack>(path, needle, 
-            
-            /// Implements @see FilesystemHaystack::ResultsCallback which will enqueue any needles we've found in the haystack into our results.
-            [this](const std::string &match)
-            {
-                m_resultsContainer->Enqueue(match);
-            },
+        needleGroups.push_back(needles);
+    }
+    else
+    {
+        for (auto &needle : needles)
+        {
+            needleGroups.push_back({ needle });
+        }
+    }
+
+    for (auto &needleGroup : needleGroups)
+    {
+        auto newHaystack = Haystack::Create(needleGroup, searchOptions, m_resultsContainer.get(),
 
-            // Implements @see FilesytemHaystack::FinishedBufferCallback which is triggered each time a haystack finishes processing a buffer.
+            // Implements @see Haystack::FinishedBufferCallback which is triggered each time a haystack finishes processing a buffer.
             // If the number of times it was processed matches the number of haystacks we're evaluating we can put it back into the
             // fileNameBuffer object for re-use, and to see if we've processed all of our total file names (in which case we can quit) :)
             [this](std::shared_ptr<FileNames> buffer)
@@ -62,7 +75,7 @@ void ResultsMonitor::InitializeHaystacksAndBuffer(const std::string &path, const
 
     // Initialize our FileNameBuffer object so that it's set up to search through the filesystem and find all the file names
     // specified, passing them to each of our haystack objects
-    m_fileNameBuffer = std::make_unique<FileNameBuffer>(path, 
+    m_fileNameBuffer = std::make_unique<FileNameBuffer>(roots, 
         // Implements @see FileNameBuffer::BufferReadyCallback, which takes a shared, populated buffer pointer and passes it to each ouf our
         // haystacks for searching.
         [this](std::shared_ptr<FileNames> buffer)
@@ -71,14 +84,19 @@ void ResultsMonitor::InitializeHaystacksAndBuffer(const std::string &path, const
             {
                 haystack->EnqueueBufferToProcess(buffer);
             }
-        }
+        },
+        walkOptions
     );
 
 }
 
-ResultsMonitor::ResultsMonitor(const std::string &path, const std::vector<std::string> &needles)
+ResultsMonitor::ResultsMonitor(const std::vector<std::string> &roots, const std::vector<std::string> &needles, const WalkOptions &walkOptions /*= WalkOptions()*/, const SearchOptions &searchOptions /*= SearchOptions()*/) :
+    // Converted in 64 bits and clamped, since 4096MB or more doesn't fit a 32 bit size_t
+    m_resultsContainer(std::make_unique<ResultSpool>(static_cast<size_t>(std::min<uint64_t>(static_cast<uint64_t>(searchOptions.ResultMemoryMB) * 1024 * 1024,
+        std::numeric_limits<size_t>::max())))),
+    m_searchOptions(searchOptions)
 {
-    InitializeHaystacksAndBuffer(path, needles);
+    InitializeHaystacksAndBuffer(roots, needles, walkOptions, searchOptions);
 }
 
 void ResultsMonitor::GetKeyboardInput()
@@ -165,13 +183,52 @@ void ResultsMonitor::MonitorKeyboardInput()
 
 void ResultsMonitor::Dump()
 {
-    while (m_resultsContainer->Size())
+    m_totalMatches += m_resultsContainer->Drain(
+        [](const std::string &match)
+        {
+            cout << match << endl;
+        }
+    );
+}
+
+void ResultsMonitor::DumpRankedResults()
+{
+    RankedResults merged(m_searchOptions.TopK > 0 ? static_cast<size_t>(m_searchOptions.TopK) : 0);
+    for (auto &haystack : m_haystacks)
+    {
+        if (haystack->Ranked() != nullptr)
+        {
+            merged.Merge(*haystack->Ranked());
+        }
+    }
+
+    for (auto &result : merged.Sorted())
     {
         m_totalMatches++;
-        cout << m_resultsContainer->Dequeue() << endl;
+        cout << "[" << result.Score << "] " << result.Match << endl;
     }
 }
 
+void ResultsMonitor::DumpSortedResults()
+{
+    std::vector<const SortedRuns*> workers;
+    for (auto &haystack : m_haystacks)
+    {
+        if (haystack->Sorted() != nullptr)
+        {
+            workers.push_back(haystack->Sorted());
+        }
+    }
+
+    m_totalMatches += SortedRuns::Merge(workers,
+        [](const std::string &match)
+        {
+            cout << match << "\n";
+        }
+    );
+    cout << flush;
+}
+
 void ResultsMonitor::Stop()
 {
     m_termianteSearch.exchange(true);
@@ -192,13 +249,26 @@ void ResultsMonitor::SearchFilesystem()
         // Start a dedicated thread to respond to keyboard input and display results
         auto monitorThread = std::make_unique<thread>(&ResultsMonitor::MonitorKeyboardInput, this);
 
-        // Start a dedicated thread to parse all filesystem file names in the specified path into a buffer
-        auto filesystemThread = std::make_unique<thread>(&FileNameBuffer::PopulateBuffers, m_fileNameBuffer.get());
+        // Start a dedicated thread to parse all filesystem file names in the specified path into a buffer. Buffers handed off early (or while
+        // waiting on a slow directory) can all be searched before the walk finishes, in which case no finished buffer callback is left to notice
+        // that everything has been processed, so we check once more when the walk is done.
+        auto filesystemThread = std::make_unique<thread>(
+            [this]()
+            {
+                m_fileNameBuffer->PopulateBuffers();
+
+                std::unique_lock<std::mutex> lock(m_bufferFinishedMutex);
+                if (m_fileNameBuffer->AllFileNamesHaveBeenProcessed())
+                {
+                    Stop();
+                }
+            }
+        );
 
         // Start a dedicated thread to find the requested needles on each of the specified haystacks
         for (auto &haystack : m_haystacks)
         {
-            auto newThread = std::make_unique<thread>(&FilesystemHaystack::FindNeedles, haystack.get());
+            auto newThread = std::make_unique<thread>(&Haystack::FindNeedles, haystack.get());
             
             m_haystackThreads.push_back(std::move(newThread));
         }
@@ -220,6 +290,18 @@ void ResultsMonitor::SearchFilesystem()
                 thread->join();
             }
         }
+
+        // Fuzzy searches rank their matches rather than streaming them, so they can only be shown once every haystack has finished
+        if (m_searchOptions.MaxEditDistance >= 0 && !m_terminatedEarly)
+        {
+            DumpRankedResults();
+        }
+
+        // Sorted searches can likewise only be merged once every haystack has finished, but the merge streams each range as soon as it's ready
+        if (m_searchOptions.Sorted && !m_terminatedEarly)
+        {
+            DumpSortedResults();
+        }
         
         // Our input thread might be stuck waiting for getline(), if so, we can go ahead and detach it.
         if (inputThread->joinable())
@@ -239,3 +321,63 @@ const int64_t fileFinder::ResultsMonitor::TotalMatches()
 {
     return m_totalMatches;
 }
+
+const int64_t fileFinder::ResultsMonitor::TotalFileNames()
+{
+    return m_fileNameBuffer->TotalFileNames();
+}
+
+const int64_t fileFinder::ResultsMonitor::RevisitedDirectories()
+{
+    return m_fileNameBuffer->RevisitedDirectories();
+}
+
+const int64_t fileFinder::ResultsMonitor::DuplicateHardlinks()
+{
+    return m_fileNameBuffer->DuplicateHardlinks();
+}
+
+const ConcurrentIdentitySet *fileFinder::ResultsMonitor::VisitedDirectories()
+{
+    return m_fileNameBuffer->VisitedDirectories();
+}
+
+const ConcurrentIdentitySet *fileFinder::ResultsMonitor::SeenHardlinks()
+{
+    return m_fileNameBuffer->SeenHardlinks();
+}
+
+std::chrono::milliseconds fileFinder::ResultsMonitor::WalkDuration()
+{
+    return m_fileNameBuffer->WalkDuration();
+}
+
+std::string fileFinder::ResultsMonitor::WalkBackend()
+{
+    return m_fileNameBuffer->BackendName();
+}
+
+const std::vector<FileNameBuffer::DeviceStatistics> &fileFinder::ResultsMonitor::DeviceStats()
+{
+    return m_fileNameBuffer->DeviceStats();
+}
+
+const BatchSizer::Statistics &fileFinder::ResultsMonitor::BatchStats()
+{
+    return m_fileNameBuffer->BatchStats();
+}
+
+const DirectoryTree *fileFinder::ResultsMonitor::Tree()
+{
+    return m_fileNameBuffer->Tree();
+}
+
+const int64_t fileFinder::ResultsMonitor::SpilledResults()
+{
+    return m_resultsContainer->SpilledResults();
+}
+
+const int64_t fileFinder::ResultsMonitor::SpilledBytes()
+{
+    return m_resultsContainer->SpilledBytes();
+}
@@ -4,11 +4,16 @@
 #include <atomic>
 #include <thread>
 #include <map>
+#include <chrono>
+#include "WalkOptions.h"
+#include "SearchOptions.h"
+#include "FileNameBuffer.h"
+#include "ResultSpool.h"
 
 namespace fileFinder
 {
-    class FilesystemHaystack;
-    class FileNameBuffer;
+    class Haystack;
+    class DirectoryTree;
     
     /// ResultsMonitor monitors filesystem-search for each, "needle" requested by the consumer as well as keyboard input while the searches complete.
     /// Note: This object will dump search results to the console every 5 seconds or when user input is received, ending search when 'q' is pressed.
@@ -24,16 +29,17 @@ namespace fileFinder
         std::mutex m_inputActionMutex;
         std::atomic<bool> m_termianteSearch {false};
         std::string m_lastKbEntry{ "" };
-        std::vector<std::unique_ptr<FilesystemHaystack>> m_haystacks;
+        std::vector<std::unique_ptr<Haystack>> m_haystacks;
         std::vector<std::unique_ptr<std::thread>> m_haystackThreads;
-        std::unique_ptr<ThreadSafeQueue<std::string>> m_resultsContainer {std::make_unique<ThreadSafeQueue<std::string>>()};
+        std::unique_ptr<ResultSpool> m_resultsContainer;
         std::atomic<int64_t> m_totalMatches {0};
         std::unique_ptr<FileNameBuffer> m_fileNameBuffer;
         bool m_terminatedEarly{ false };
+        SearchOptions m_searchOptions;
         
-        /// Initializes FileNameBuffer that will populate FilesytemHaystack objects with file names recursively from the directory specified, as well as 
+        /// Initializes FileNameBuffer that will populate Haystack objects with file names recursively from the directory specified, as well as 
         /// the haystacks and threads used to search them based on the number of needles specified.
-        void InitializeHaystacksAndBuffer(const std::string &path, const std::vector<std::string> &needles);
+        void InitializeHaystacksAndBuffer(const std::vector<std::string> &roots, const std::vector<std::string> &needles, const WalkOptions &walkOptions, const SearchOptions &searchOptions);
         
         ///  Function to be run as a thread and set m_nextAction based on input received
         void GetKeyboardInput();
@@ -44,12 +50,18 @@ namespace fileFinder
         ///  Dumps search results to the console 
         void Dump();
 
+        ///  Merges the ranked results of each haystack for fuzzy searches and dumps the best of them to the console, best first
+        void DumpRankedResults();
+
+        ///  Merges the sorted runs of each haystack and dumps them to the console in order, each distinct path once
+        void DumpSortedResults();
+
         ///  Triggers all threads to stop processing their results and terminates the check for keyboard input.
         void Stop();
 
     public:
 
-        ResultsMonitor(const std::string &path, const std::vector<std::string> &needles);
+        ResultsMonitor(const std::vector<std::string> &roots, const std::vector<std::string> &needles, const WalkOptions &walkOptions = WalkOptions(), const SearchOptions &searchOptions = SearchOptions());
 
         /// Will search the filesystem for all of the needles specified in the constructor.
         void SearchFilesystem();
@@ -59,5 +71,41 @@ namespace fileFinder
 
         /// Will indicate the total number of matching files found during the search.
         const int64_t TotalMatches();
+
+        /// Will indicate the total number of file names enumerated during the search.
+        const int64_t TotalFileNames();
+
+        /// Will indicate how many directories were reached again through another path and not entered.
+        const int64_t RevisitedDirectories();
+
+        /// Will indicate how many duplicate hard links were left out of the search.
+        const int64_t DuplicateHardlinks();
+
+        /// Returns the set of directories entered, or nullptr if symbolic links aren't followed
+        const ConcurrentIdentitySet *VisitedDirectories();
+
+        /// Returns the set of files with more than one hard link seen, or nullptr if duplicate hard links aren't suppressed
+        const ConcurrentIdentitySet *SeenHardlinks();
+
+        /// Will indicate how long it took to enumerate all of the file names in the path.
+        std::chrono::milliseconds WalkDuration();
+
+        /// Will describe the filesystem enumeration backend used for the search.
+        std::string WalkBackend();
+
+        /// Will return the throughput figures for each device walked.
+        const std::vector<FileNameBuffer::DeviceStatistics> &DeviceStats();
+
+        /// Will return how the number of file names in each buffer was adapted over the walk.
+        const BatchSizer::Statistics &BatchStats();
+
+        /// Will return the tree of every entry walked if @see WalkOptions::CompactTree was set, otherwise nullptr.
+        const DirectoryTree *Tree();
+
+        /// Will indicate how many matches were written to disk because they didn't fit in the result memory budget.
+        const int64_t SpilledResults();
+
+        /// Will indicate how many bytes of matches were written to disk.
+        const int64_t SpilledBytes();
     };
 }
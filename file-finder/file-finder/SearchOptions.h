@@ -0,0 +1,34 @@
+#pragma once
+
+namespace fileFinder
+{
+    /// SearchOptions is a struct produced by @see CommandLineParser and consumed by @see ResultsMonitor and @see FilesystemHaystack to select what is searched and how.
+    struct SearchOptions
+    {
+        /// When true the needles are searched for in the contents of each file rather than in its name, and matching paths are reported.
+        bool Content{ false };
+
+        /// When zero or more, file names within this many edits (insertions, deletions, or substitutions) of a needle match, and only the
+        /// best TopK matches are reported, ranked by edit distance, once the search completes. A value less than zero selects exact matching.
+        int MaxEditDistance{ -1 };
+
+        /// The number of ranked matches reported by fuzzy searches @see SearchOptions::MaxEditDistance
+        int TopK{ 50 };
+
+        /// When true ASCII letters in the needles match regardless of case
+        bool IgnoreCase{ false };
+
+        /// When true a single haystack searches for every needle in one pass over each file name (or file), and each match is reported once
+        /// however many needles it contains, rather than one haystack (and one thread) per needle. Always set for content searches, so each file is
+        /// only read once.
+        bool MultiPattern{ false };
+
+        /// The number of megabytes of matches kept in memory between dumps, any more are written to a temporary file @see ResultSpool.
+        /// A value of zero keeps every match in memory.
+        int ResultMemoryMB{ 256 };
+
+        /// When true each haystack keeps its matches in sorted runs, and once the search completes the runs are merged into a single sorted list
+        /// of full paths, with each path reported once however many needles it matched @see SortedRuns
+        bool Sorted{ false };
+    };
+}
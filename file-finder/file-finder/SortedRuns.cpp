@@ -0,0 +1,203 @@
+#include <iostream>
+#include <algorithm>
+#include <future>
+#include <queue>
+#include <thread>
+#include "SortedRuns.h"
+
+using namespace std;
+using namespace fileFinder;
+
+namespace
+{
+    typedef std::vector<std::string>::const_iterator RunIterator;
+
+    /// The part of one run that falls inside a partition's key range
+    struct RunRange
+    {
+        RunIterator Cursor;
+        RunIterator End;
+    };
+
+    /// Merges the ranges given with a min-heap of their cursors, skipping any match equal to the one before it
+    std::vector<const std::string*> MergeRanges(std::vector<RunRange> ranges)
+    {
+        auto isLater = [](const RunRange &left, const RunRange &right)
+        {
+            return *right.Cursor < *left.Cursor;
+        };
+
+        std::priority_queue<RunRange, std::vector<RunRange>, decltype(isLater)> heap(isLater);
+        size_t total = 0;
+        for (auto &range : ranges)
+        {
+            if (range.Cursor != range.End)
+            {
+                total += static_cast<size_t>(range.End - range.Cursor);
+                heap.push(range);
+            }
+        }
+
+        std::vector<const std::string*> merged;
+        try
+        {
+            merged.reserve(total);
+            while (!heap.empty())
+            {
+                auto range = heap.top();
+                heap.pop();
+                if (merged.empty() || *merged.back() != *range.Cursor)
+                {
+                    merged.push_back(&*range.Cursor);
+                }
+                if (++range.Cursor != range.End)
+                {
+                    heap.push(range);
+                }
+            }
+        }
+        catch (const std::bad_alloc &ex)
+        {
+            std::cout << " Error bad allocation caught in " << __FILE__ << " at line " << __LINE__ << endl;
+            std::cout << " Exception: " << ex.what() << endl;
+            std::terminate();
+        }
+        return merged;
+    }
+}
+
+void SortedRuns::AddRun(std::vector<std::string> &run)
+{
+    if (run.empty())
+    {
+        return;
+    }
+
+    std::sort(run.begin(), run.end());
+    run.erase(std::unique(run.begin(), run.end()), run.end());
+    try
+    {
+        m_runs.push_back(std::move(run));
+    }
+    catch (const std::bad_alloc &ex)
+    {
+        std::cout << " Error bad allocation caught in " << __FILE__ << " at line " << __LINE__ << endl;
+        std::cout << " Exception: " << ex.what() << endl;
+        std::terminate();
+    }
+    run.clear();
+
+    // Keep each run at least twice the size of the one after it, so every match is only merged a logarithmic number of times
+    while (m_runs.size() >= 2 && m_runs[m_runs.size() - 2].size() <= 2 * m_runs.back().size())
+    {
+        MergeNewestRuns();
+    }
+}
+
+void SortedRuns::MergeNewestRuns()
+{
+    auto &older = m_runs[m_runs.size() - 2];
+    auto &newer = m_runs.back();
+
+    std::vector<std::string> merged;
+    try
+    {
+        merged.reserve(older.size() + newer.size());
+        auto left = older.begin();
+        auto right = newer.begin();
+        while (left != older.end() || right != newer.end())
+        {
+            bool takeLeft = (right == newer.end()) || (left != older.end() && *left <= *right);
+            auto &next = takeLeft ? left : right;
+            if (merged.empty() || merged.back() != *next)
+            {
+                merged.push_back(std::move(*next));
+            }
+            ++next;
+        }
+    }
+    catch (const std::bad_alloc &ex)
+    {
+        std::cout << " Error bad allocation caught in " << __FILE__ << " at line " << __LINE__ << endl;
+        std::cout << " Exception: " << ex.what() << endl;
+        std::terminate();
+    }
+
+    m_runs.pop_back();
+    m_runs.back().swap(merged);
+}
+
+size_t SortedRuns::Size() const
+{
+    size_t size = 0;
+    for (auto &run : m_runs)
+    {
+        size += run.size();
+    }
+    return size;
+}
+
+int64_t SortedRuns::Merge(const std::vector<const SortedRuns*> &workers, const std::function<void(const std::string&)> &output)
+{
+    std::vector<const std::vector<std::string>*> runs;
+    size_t total = 0;
+    for (auto worker : workers)
+    {
+        for (auto &run : worker->m_runs)
+        {
+            runs.push_back(&run);
+            total += run.size();
+        }
+    }
+
+    // Choose the partition boundaries from evenly spaced samples of every run, so each partition gets roughly the same number of matches
+    size_t partitions = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), total / MIN_PARTITION_SIZE));
+    std::vector<std::string> boundaries;
+    if (partitions > 1)
+    {
+        std::vector<std::string> samples;
+        for (auto run : runs)
+        {
+            size_t step = std::max<size_t>(1, run->size() / (partitions * SAMPLES_PER_PARTITION));
+            for (size_t ix = step / 2; ix < run->size(); ix += step)
+            {
+                samples.push_back((*run)[ix]);
+            }
+        }
+        std::sort(samples.begin(), samples.end());
+        for (size_t partition = 1; partition < partitions; partition++)
+        {
+            auto &boundary = samples[partition * samples.size() / partitions];
+            if (boundaries.empty() || boundaries.back() < boundary)
+            {
+                boundaries.push_back(boundary);
+            }
+        }
+    }
+
+    // Partition p covers matches from boundaries[p - 1] up to but not including boundaries[p], so equal matches always land in the same partition
+    // and duplicates never cross a boundary
+    std::vector<std::future<std::vector<const std::string*>>> merges;
+    for (size_t partition = 0; partition <= boundaries.size(); partition++)
+    {
+        std::vector<RunRange> ranges;
+        for (auto run : runs)
+        {
+            auto begin = (partition == 0) ? run->begin() : std::lower_bound(run->begin(), run->end(), boundaries[partition - 1]);
+            auto end = (partition == boundaries.size()) ? run->end() : std::lower_bound(run->begin(), run->end(), boundaries[partition]);
+            ranges.push_back(RunRange{ begin, end });
+        }
+        merges.push_back(std::async(std::launch::async, MergeRanges, std::move(ranges)));
+    }
+
+    int64_t outputCount = 0;
+    for (auto &merge : merges)
+    {
+        for (auto match : merge.get())
+        {
+            output(*match);
+            outputCount++;
+        }
+    }
+    return outputCount;
+}
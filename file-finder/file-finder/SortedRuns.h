@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <functional>
+#include <cstdint>
+
+namespace fileFinder
+{
+    /// SortedRuns holds one worker's matches as a small number of sorted, duplicate free runs, so each worker can keep its matches in order
+    /// without any locking. Each buffer's matches are added as a new run, and the newest runs are merged together whenever they grow to a similar
+    /// size, which keeps the number of runs logarithmic in the number of matches. Workers' runs are combined with @see SortedRuns::Merge once the
+    /// search is complete.
+    class SortedRuns
+    {
+    private:
+        /// Partitions smaller than this aren't worth a thread of their own when merging
+        static constexpr size_t MIN_PARTITION_SIZE{ 64 * 1024 };
+
+        /// The number of evenly spaced samples taken from each run for every partition, to choose the partition boundaries
+        static constexpr size_t SAMPLES_PER_PARTITION{ 8 };
+
+        std::vector<std::vector<std::string>> m_runs;
+
+        /// Merges the newest run into the one before it, dropping duplicates
+        void MergeNewestRuns();
+
+    public:
+        SortedRuns() = default;
+
+        /// Sorts the matches in run, drops any duplicates, and adds them as a new run, leaving run empty.
+        void AddRun(std::vector<std::string> &run);
+
+        /// Returns the number of matches held across every run
+        size_t Size() const;
+
+        /// Merges the runs of every worker into a single ordered stream, passing each distinct match to output once, and returns the number of
+        /// matches output. The runs are split into key ranges that are merged in parallel, and each range is output as soon as it and the ranges
+        /// before it are ready.
+        static int64_t Merge(const std::vector<const SortedRuns*> &workers, const std::function<void(const std::string&)> &output);
+    };
+}
@@ -2,6 +2,7 @@
 #include <queue>
 #include <mutex>
 #include <condition_variable>
+#include <chrono>
 
 namespace fileFinder
 {
@@ -23,6 +24,9 @@ namespace fileFinder
         ///  Dequeue an element of type T, but sleep the thread if no elements exist in the queue yet until Enqueue is called. 
         T Dequeue();
 
+        ///  Dequeue an element of type T into t, sleeping the thread for at most timeout if no elements exist in the queue yet. Returns false if the wait timed out.
+        bool TryDequeue(T &t, std::chrono::steady_clock::duration timeout);
+
         ///  Returns the number of items in the queue
         size_t Size();
     };
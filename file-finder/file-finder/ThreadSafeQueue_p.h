@@ -33,6 +33,19 @@ namespace fileFinder {
         return val;
     }
 
+    template <class T>
+    bool ThreadSafeQueue<T>::TryDequeue(T &t, std::chrono::steady_clock::duration timeout)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_condition.wait_for(lock, timeout, [this] { return !m_queue.empty(); }))
+        {
+            return false;
+        }
+        t = m_queue.front();
+        m_queue.pop();
+        return true;
+    }
+
     template <class T>
     size_t ThreadSafeQueue<T>::Size()
     {
@@ -0,0 +1,51 @@
+#pragma once
+#include <vector>
+#include <string>
+
+namespace fileFinder
+{
+    /// The order directories are read in by @see AsyncDirectoryWalker
+    enum class TraversalOrder
+    {
+        /// The deepest directory waiting is read first, like recursive_directory_iterator
+        DepthFirst,
+        /// The shallowest directory waiting is read first, so matches near the roots are found before those deep in large subtrees
+        BreadthFirst,
+        /// Directories at or under one of @see WalkOptions::PreferredDirectories are read first, then the rest breadth first
+        Priority
+    };
+
+    /// WalkOptions is a struct produced by @see CommandLineParser and consumed by @see FileNameBuffer to select how the filesystem is enumerated.
+    struct WalkOptions
+    {
+        /// Number of directory reads that may be in flight at once on each device. A value of zero selects the synchronous recursive_directory_iterator walker,
+        /// any other value selects @see AsyncDirectoryWalker with that many outstanding directory reads.
+        int QueueDepth{ 0 };
+
+        /// When true each buffer also carries the full path of every file name in @see FileNames::Paths
+        bool CollectPaths{ false };
+
+        /// When true every entry walked is recorded in a @see DirectoryTree, which is then the only copy of the names: buffers carry ranges of entry IDs
+        /// rather than names, and full paths are rebuilt from the tree when they're needed (so CollectPaths has no effect). The tree is built from
+        /// whole directory listings, so this requires the asynchronous walker (QueueDepth of at least one).
+        bool CompactTree{ false };
+
+        /// When true directories mounted from a different device to the root they were found under are listed but not descended into
+        bool OneFileSystem{ false };
+
+        /// When true symbolic links to directories are descended into. Every directory's device and file index is recorded as it's read, so a
+        /// directory reached through a second path (a link cycle, or overlapping roots) is listed but never entered twice.
+        bool FollowSymlinks{ false };
+
+        /// When true a file with more than one hard link is only returned the first time it's reached
+        bool DedupeHardlinks{ false };
+
+        /// The order directories are read in. Only depth first is supported by the synchronous walker, any other order requires the asynchronous
+        /// walker (QueueDepth of at least one).
+        TraversalOrder Order{ TraversalOrder::DepthFirst };
+
+        /// Directories to read before any others when Order is @see TraversalOrder::Priority. A hint containing a path separator matches that
+        /// directory and everything under it, any other hint matches every directory with that name (and everything under them).
+        std::vector<std::string> PreferredDirectories;
+    };
+}
@@ -0,0 +1,91 @@
+#include <iostream>
+#include "WorkerPool.h"
+
+using namespace std;
+using namespace fileFinder;
+
+namespace
+{
+    thread_local bool onWorkerThread{ false };
+}
+
+WorkerPool::WorkerPool(size_t threadCount)
+{
+    for (size_t ix = 0; ix < std::max<size_t>(1, threadCount); ix++)
+    {
+        m_threads.push_back(std::make_unique<thread>(&WorkerPool::RunTasks, this));
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+
+    for (auto &thread : m_threads)
+    {
+        if (thread->joinable())
+        {
+            thread->join();
+        }
+    }
+}
+
+void WorkerPool::RunTasks()
+{
+    onWorkerThread = true;
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (m_tasks.empty() && !m_stopping)
+            {
+                m_condition.wait(lock);
+            }
+            if (m_tasks.empty())
+            {
+                return;
+            }
+            task = std::move(m_tasks.front());
+            m_tasks.pop();
+        }
+        task();
+    }
+}
+
+std::future<void> WorkerPool::Run(std::function<void()> task)
+{
+    // std::function has to be copyable, so the packaged task that fulfils the future is shared with it
+    auto packagedTask = std::make_shared<std::packaged_task<void()>>(std::move(task));
+    auto done = packagedTask->get_future();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        try
+        {
+            m_tasks.push([packagedTask]() { (*packagedTask)(); });
+        }
+        catch (const std::bad_alloc &ex)
+        {
+            std::cout << " Error bad allocation caught in " << __FILE__ << " at line " << __LINE__ << endl;
+            std::cout << " Exception: " << ex.what() << endl;
+            std::terminate();
+        }
+    }
+    m_condition.notify_one();
+    return done;
+}
+
+WorkerPool &WorkerPool::Shared()
+{
+    static WorkerPool pool(std::thread::hardware_concurrency());
+    return pool;
+}
+
+bool WorkerPool::OnWorkerThread()
+{
+    return onWorkerThread;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+
+namespace fileFinder
+{
+    /// WorkerPool runs tasks on a fixed set of threads that are started once, rather than starting a thread per task. Tasks are run in the order
+    /// they're queued, and must not wait on other tasks in the same pool.
+    /// sample usage:
+    /// auto done = WorkerPool::Shared().Run([&]() { ... });
+    /// done.get();
+    class WorkerPool
+    {
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        std::queue<std::function<void()>> m_tasks;
+        std::vector<std::unique_ptr<std::thread>> m_threads;
+        bool m_stopping{ false };
+
+        /// Function to be run as a thread that runs queued tasks until the pool is destroyed.
+        void RunTasks();
+
+    public:
+        /// Starts threadCount threads (at least one)
+        explicit WorkerPool(size_t threadCount);
+
+        WorkerPool() = delete;
+
+        /// Copying this object is not part of our use case, so we'll set it up as non-copyable
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        /// Runs any tasks still queued and joins the threads.
+        ~WorkerPool();
+
+        /// Queues task to be run on one of the pool's threads, the future returned becomes ready once it has run.
+        std::future<void> Run(std::function<void()> task);
+
+        /// Returns the pool shared by the whole process, with one thread per hardware thread, started the first time it's used.
+        static WorkerPool &Shared();
+
+        /// Returns true if called from a thread belonging to any WorkerPool, where a task must do its work itself rather than queue more tasks
+        /// and wait on them.
+        static bool OnWorkerThread();
+    };
+}
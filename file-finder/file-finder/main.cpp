@@ -6,8 +6,10 @@
 #include "FileNameBuffer.h"
 #include "ThreadSafeQueue.h"
 #include "CommandLineParser.h"
-#include "FilesystemHaystack.h"
+#include "Haystack.h"
 #include "ResultsMonitor.h"
+#include "DirectoryTree.h"
+#include "ConcurrentIdentitySet.h"
 
 using namespace std;
 using namespace fileFinder;
@@ -17,7 +19,8 @@ void ShowIntroMessage(const CommandLineParser &parser)
 {
     // A little bit of helper text we could display
     cout << ">>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>" << endl;
-    cout << ">>> File Finder will now rescursively search \"" << parser.Path() << "\" for matching files names. " << endl;
+    auto otherRoots = parser.Roots().size() - 1;
+    cout << ">>> File Finder will now rescursively search \"" << parser.Path() << "\"" << (otherRoots > 0 ? " and " + std::to_string(otherRoots) + " other root(s)" : "") << " for matching " << (parser.SearchSettings().Content ? "file contents. " : "files names. ") << endl;
     cout << ">>> Results will display every 5-10 seconds until all searches are complete." << endl;
     cout << ">>> Type 'dump' and press Enter to show records so far." << endl;
     cout << ">>> Type 'quit' and press Enter to show records so far and quit." << endl;
@@ -28,6 +31,70 @@ void ShowIntroMessage(const CommandLineParser &parser)
     cout << ">>> Searching..." << endl << endl;
 }
 
+void ShowTreeStatistics(const DirectoryTree *tree)
+{
+    if (tree == nullptr || tree->Size() == 0)
+    {
+        return;
+    }
+
+    double entries = static_cast<double>(tree->Size());
+    cout << ">>> Compact tree: " << tree->Size() << " entries, " << (tree->MemoryUsage() / entries) << " bytes/entry (" << tree->MemoryUsage()
+         << " bytes) vs " << (tree->StringLayoutMemoryUsage() / entries) << " bytes/entry (" << tree->StringLayoutMemoryUsage() << " bytes) as std::string names." << endl;
+}
+
+void ShowDeviceStatistics(const std::vector<FileNameBuffer::DeviceStatistics> &devices)
+{
+    // A single device's throughput is already shown by the totals
+    if (devices.size() < 2)
+    {
+        return;
+    }
+
+    for (auto &device : devices)
+    {
+        cout << ">>> Device " << device.Device << " (" << device.Roots.size() << " root" << (device.Roots.size() == 1 ? "" : "s") << "): " << device.FileNames
+             << " file names in " << device.Directories << " directories in " << device.Duration.count() << "ms";
+        if (device.Duration.count() > 0)
+        {
+            cout << " (" << (device.FileNames * 1000 / device.Duration.count()) << " names/s)";
+        }
+        cout << endl;
+    }
+}
+
+void ShowBatchStatistics(const BatchSizer::Statistics &batches)
+{
+    if (batches.Batches == 0)
+    {
+        return;
+    }
+
+    cout << ">>> Batches: " << batches.Batches << " handed off averaging " << (batches.Names / batches.Batches) << " file names, limit ranged from "
+         << batches.SmallestLimit << " to " << batches.LargestLimit << " (grew " << batches.Grew << " times, shrank " << batches.Shrank << " times) and ended at "
+         << batches.FinalLimit << "." << endl;
+}
+
+void ShowDuplicateStatistics(int64_t revisitedDirectories, int64_t duplicateHardlinks)
+{
+    if (revisitedDirectories > 0 || duplicateHardlinks > 0)
+    {
+        cout << ">>> Skipped " << revisitedDirectories << " directories already visited and " << duplicateHardlinks << " duplicate hard links." << endl;
+    }
+}
+
+void ShowIdentitySetStatistics(const ConcurrentIdentitySet *visitedDirectories, const ConcurrentIdentitySet *seenHardlinks)
+{
+    if (visitedDirectories != nullptr)
+    {
+        cout << ">>> Visited directory set: " << visitedDirectories->Size() << " directories in " << visitedDirectories->MemoryUsage() << " bytes." << endl;
+    }
+    if (seenHardlinks != nullptr)
+    {
+        cout << ">>> Hard link set: " << seenHardlinks->Size() << " files in " << seenHardlinks->MemoryUsage() << " bytes." << endl;
+    }
+}
+
 void ShowClosingMessage(ResultsMonitor &searchResultsMonitor)
 {
     cout << endl << ">>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>" << endl;
@@ -40,9 +107,48 @@ void ShowClosingMessage(ResultsMonitor &searchResultsMonitor)
         cout << ">>> Search complete!" << endl;
     }
     cout << ">>> Total matches: " << searchResultsMonitor.TotalMatches() << endl;
+    if (searchResultsMonitor.SpilledResults() > 0)
+    {
+        cout << ">>> " << searchResultsMonitor.SpilledResults() << " matches (" << searchResultsMonitor.SpilledBytes() << " bytes) didn't fit in the result memory budget and were spooled to disk." << endl;
+    }
+    cout << ">>> Enumerated " << searchResultsMonitor.TotalFileNames() << " file names in " << searchResultsMonitor.WalkDuration().count()
+         << "ms using the " << searchResultsMonitor.WalkBackend() << " walker." << endl;
+    ShowBatchStatistics(searchResultsMonitor.BatchStats());
+    ShowDuplicateStatistics(searchResultsMonitor.RevisitedDirectories(), searchResultsMonitor.DuplicateHardlinks());
+    ShowIdentitySetStatistics(searchResultsMonitor.VisitedDirectories(), searchResultsMonitor.SeenHardlinks());
+    ShowDeviceStatistics(searchResultsMonitor.DeviceStats());
+    ShowTreeStatistics(searchResultsMonitor.Tree());
     cout << ">>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>" << endl;
 }
 
+void RunBenchmark(const CommandLineParser &parser)
+{
+    // Enumerate the path without searching it, recycling each buffer as soon as it's ready, so that only the walker itself is measured.
+    // Comparing backends is only meaningful on a cold cache, so each run should be made in a fresh process after flushing the file cache.
+    std::unique_ptr<FileNameBuffer> fileNameBuffer;
+    fileNameBuffer = make_unique<FileNameBuffer>(parser.Roots(),
+        [&fileNameBuffer](std::shared_ptr<FileNames> buffer)
+        {
+            fileNameBuffer->EnqueueProcessedBuffer(buffer);
+        },
+        parser.WalkSettings()
+    );
+    fileNameBuffer->PopulateBuffers();
+
+    auto elapsed = fileNameBuffer->WalkDuration().count();
+    cout << ">>> Benchmark: " << fileNameBuffer->BackendName() << " walker enumerated " << fileNameBuffer->TotalFileNames() << " file names in " << elapsed << "ms";
+    if (elapsed > 0)
+    {
+        cout << " (" << (fileNameBuffer->TotalFileNames() * 1000 / elapsed) << " names/s)";
+    }
+    cout << endl;
+    ShowBatchStatistics(fileNameBuffer->BatchStats());
+    ShowDuplicateStatistics(fileNameBuffer->RevisitedDirectories(), fileNameBuffer->DuplicateHardlinks());
+    ShowIdentitySetStatistics(fileNameBuffer->VisitedDirectories(), fileNameBuffer->SeenHardlinks());
+    ShowDeviceStatistics(fileNameBuffer->DeviceStats());
+    ShowTreeStatistics(fileNameBuffer->Tree());
+}
+
 int main(int argc, char *argv[])
 {
     std::unique_ptr<CommandLineParser> parser = make_unique<CommandLineParser>(argc, argv);
@@ -53,9 +159,15 @@ int main(int argc, char *argv[])
         return -1;
     }
 
+    if (parser->Benchmark())
+    {
+        RunBenchmark(*parser);
+        return 0;
+    }
+
     ShowIntroMessage(*parser);
 
-    std::unique_ptr<ResultsMonitor> searchResultsMonitor = make_unique<ResultsMonitor>(parser->Path(), parser->Needles());
+    std::unique_ptr<ResultsMonitor> searchResultsMonitor = make_unique<ResultsMonitor>(parser->Roots(), parser->Needles(), parser->WalkSettings(), parser->SearchSettings());
     searchResultsMonitor->SearchFilesystem();
 
     if(!searchResultsMonitor->TerminatedEarly())